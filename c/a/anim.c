@@ -0,0 +1,225 @@
+#define _DEFAULT_SOURCE // For MAP_POPULATE, htole32(3) & co. (fix warning on linux).
+#include <endian.h>     // htole32(3) & co.
+#include <errno.h>      // errno(3).
+#include <fcntl.h>      // open(2).
+#include <stdlib.h>     // realloc(3), free(3).
+#include <string.h>     // memcmp(3), memcpy(3).
+#include <sys/mman.h>   // mmap(2), munmap(2).
+#include <sys/stat.h>   // fstat(2).
+#include <unistd.h>     // close(2).
+
+#include "anim.h"
+
+// anim_open maps the animation file and checks its layout.
+// Pages are populated upfront so the playback doesn't fault.
+// Returns -1 with errno set on failure.
+int             anim_open(anim_t* anim, const char* path) {
+  struct stat   st;
+  uint64_t      size;
+  int           fd;
+
+  memset(anim, 0, sizeof(*anim));
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  errno = ENOTSUP;
+  return -1;
+#endif
+
+  if ((fd = open(path, O_RDONLY)) < 0) {
+    return -1;
+  }
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return -1;
+  }
+  if ((size_t)st.st_size < sizeof(anim_header)) {
+    close(fd);
+    errno = EINVAL;
+    return -1;
+  }
+  anim->size = st.st_size;
+  anim->map  = mmap(NULL, anim->size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+  close(fd);
+  if (anim->map == MAP_FAILED) {
+    anim->map = NULL;
+    return -1;
+  }
+
+  // Check the header and that the frames and index fill the file.
+  anim->header = anim->map;
+  size         = sizeof(anim_header) + (uint64_t)anim->header->frames * sizeof(cube_t) + (uint64_t)anim->header->entries * sizeof(anim_entry);
+  if (memcmp(anim->header->magic, ANIM_MAGIC, sizeof(anim->header->magic)) ||
+      anim->header->version != ANIM_VERSION ||
+      anim->header->frame_size != sizeof(cube_t) ||
+      !anim->header->entries ||
+      size != anim->size) {
+    anim_close(anim);
+    errno = EINVAL;
+    return -1;
+  }
+  anim->frames  = (cube_t*)((char*)anim->map + sizeof(anim_header));
+  anim->index   = (const anim_entry*)(anim->frames + anim->header->frames);
+  anim->entries = anim->header->entries;
+
+  // Check each step once, so the playback doesn't have to.
+  for (uint32_t i = 0; i < anim->entries; i++) {
+    if (anim->index[i].frame >= anim->header->frames) {
+      anim_close(anim);
+      errno = EINVAL;
+      return -1;
+    }
+  }
+
+  // Played from start to end.
+  madvise(anim->map, anim->size, MADV_SEQUENTIAL);
+  return 0;
+}
+
+// anim_close unmaps the animation.
+void    anim_close(anim_t* anim) {
+  if (anim->map) {
+    munmap(anim->map, anim->size);
+  }
+  memset(anim, 0, sizeof(*anim));
+}
+
+// hash_frame is FNV-1a on the frame bytes.
+static uint32_t hash_frame(cube_t frame) {
+  const uint8_t* bytes = &frame[0][0];
+  uint32_t       hash  = 2166136261U;
+
+  for (unsigned int i = 0; i < sizeof(cube_t); i++) {
+    hash = (hash ^ bytes[i]) * 16777619U;
+  }
+  return hash;
+}
+
+// grow doubles the capacity of an array, at least to min.
+static int      grow(void** array, uint32_t* cap, uint32_t min, size_t size) {
+  uint32_t      n = *cap ? *cap * 2 : 1024;
+  void*         p;
+
+  while (n < min) {
+    n *= 2;
+  }
+  if (!(p = realloc(*array, n * size))) {
+    return -1;
+  }
+  *array = p;
+  *cap   = n;
+  return 0;
+}
+
+// find_frame looks up the frame in the hash table.
+// Returns the slot of the frame, or of the empty slot to insert it.
+static uint32_t find_frame(const anim_writer* writer, cube_t frame) {
+  uint32_t      slot = hash_frame(frame) & (writer->table_size - 1);
+
+  while (writer->table[slot] && memcmp(writer->frames[writer->table[slot] - 1], frame, sizeof(cube_t))) {
+    slot = (slot + 1) & (writer->table_size - 1);
+  }
+  return slot;
+}
+
+// rehash doubles the hash table size.
+static int      rehash(anim_writer* writer) {
+  uint32_t      size = writer->table_size ? writer->table_size * 2 : 4096;
+  uint32_t*     table;
+
+  if (!(table = calloc(size, sizeof(*table)))) {
+    return -1;
+  }
+  free(writer->table);
+  writer->table      = table;
+  writer->table_size = size;
+  for (uint32_t i = 0; i < writer->frames_count; i++) {
+    writer->table[find_frame(writer, writer->frames[i])] = i + 1;
+  }
+  return 0;
+}
+
+// anim_writer_open creates the animation file.
+// Returns -1 with errno set on failure.
+int     anim_writer_open(anim_writer* writer, const char* path) {
+  memset(writer, 0, sizeof(*writer));
+  if (!(writer->file = fopen(path, "wb"))) {
+    return -1;
+  }
+  if (rehash(writer) < 0) {
+    fclose(writer->file);
+    return -1;
+  }
+  return 0;
+}
+
+// anim_writer_add appends a step, the frame displayed for the given time.
+// Returns -1 with errno set on failure.
+int             anim_writer_add(anim_writer* writer, cube_t frame, uint32_t duration_us) {
+  anim_entry*   last = writer->entries ? &writer->index[writer->entries - 1] : NULL;
+  uint32_t      slot;
+
+  writer->duration_us += duration_us;
+
+  // Same frame as the previous step, stretch it, as long as it fits.
+  if (last && !memcmp(writer->frames[last->frame], frame, sizeof(cube_t)) && last->duration_us <= UINT32_MAX - duration_us) {
+    last->duration_us += duration_us;
+    return 0;
+  }
+
+  // Store the frame if we haven't seen it yet.
+  slot = find_frame(writer, frame);
+  if (!writer->table[slot]) {
+    if (writer->frames_count == writer->frames_cap &&
+        grow((void**)&writer->frames, &writer->frames_cap, writer->frames_count + 1, sizeof(cube_t)) < 0) {
+      return -1;
+    }
+    memcpy(writer->frames[writer->frames_count++], frame, sizeof(cube_t));
+    writer->table[slot] = writer->frames_count;
+    if (writer->frames_count * 2 > writer->table_size && rehash(writer) < 0) {
+      return -1;
+    }
+    slot = find_frame(writer, frame);
+  }
+
+  // Add the step.
+  if (writer->entries == writer->entries_cap &&
+      grow((void**)&writer->index, &writer->entries_cap, writer->entries + 1, sizeof(anim_entry)) < 0) {
+    return -1;
+  }
+  writer->index[writer->entries].frame       = writer->table[slot] - 1;
+  writer->index[writer->entries].duration_us = duration_us;
+  writer->entries++;
+  return 0;
+}
+
+// anim_writer_close writes the header, frames and index, and closes the file.
+// Returns -1 with errno set on failure.
+int             anim_writer_close(anim_writer* writer) {
+  anim_header   header = {
+    .magic       = ANIM_MAGIC,
+    .version     = htole32(ANIM_VERSION),
+    .frame_size  = htole32(sizeof(cube_t)),
+    .frames      = htole32(writer->frames_count),
+    .entries     = htole32(writer->entries),
+    .duration_us = htole64(writer->duration_us),
+  };
+  int           ret = 0;
+
+  for (uint32_t i = 0; i < writer->entries; i++) {
+    writer->index[i].frame       = htole32(writer->index[i].frame);
+    writer->index[i].duration_us = htole32(writer->index[i].duration_us);
+  }
+  if (fwrite(&header, sizeof(header), 1, writer->file) != 1 ||
+      fwrite(writer->frames, sizeof(cube_t), writer->frames_count, writer->file) != writer->frames_count ||
+      fwrite(writer->index, sizeof(anim_entry), writer->entries, writer->file) != writer->entries) {
+    ret = -1;
+  }
+  if (fclose(writer->file) && !ret) {
+    ret = -1;
+  }
+  free(writer->frames);
+  free(writer->index);
+  free(writer->table);
+  memset(writer, 0, sizeof(*writer));
+  return ret;
+}
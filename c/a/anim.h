@@ -0,0 +1,94 @@
+#ifndef __ANIM_H__
+# define __ANIM_H__
+
+# include <stddef.h> // size_t.
+# include <stdint.h> // uint32_t & co.
+# include <stdio.h>  // FILE.
+
+# include "cube.h"   // cube_t.
+
+/**
+   Baked animations, pre-rendered frames played back from a memory mapped file.
+
+   File layout, integers little-endian (the Pi and x86 byte order, the only ones supported):
+     - anim_header, 64 bytes,
+     - the frames, one cube_t (64 bytes) each,
+     - the index, one anim_entry per step: which frame to display and for how long.
+
+   The writer stores each distinct frame once and merges repeated frames in a single
+   step, so loops and still parts cost an index entry only.
+
+   Example:
+
+   anim_t        anim;
+
+   if (anim_open(&anim, "show.anim") < 0) {
+     ...
+   }
+   for (uint32_t i = 0; i < anim.entries; i++) {
+     render(anim_frame(&anim, i));       // Points in the mapping, no copy.
+     usleep(anim_duration(&anim, i));
+   }
+   anim_close(&anim);
+*/
+
+# define ANIM_MAGIC   "CUBEANIM"
+# define ANIM_VERSION 1
+
+typedef struct {
+    char            magic[8];     // ANIM_MAGIC.
+    uint32_t        version;      // ANIM_VERSION.
+    uint32_t        frame_size;   // sizeof(cube_t), to reject other cube sizes.
+    uint32_t        frames;       // Number of distinct frames.
+    uint32_t        entries;      // Number of steps in the index.
+    uint64_t        duration_us;  // Total duration.
+    uint8_t         reserved[32];
+}                   anim_header;
+
+typedef struct {
+    uint32_t        frame;        // Frame to display.
+    uint32_t        duration_us;  // Display time.
+}                   anim_entry;
+
+// Mapped animation.
+typedef struct {
+    void*               map;
+    size_t              size;
+    const anim_header*  header;
+    cube_t*             frames;   // Read only mapping.
+    const anim_entry*   index;
+    uint32_t            entries;
+}                       anim_t;
+
+int     anim_open(anim_t* anim, const char* path);
+void    anim_close(anim_t* anim);
+
+// anim_frame returns the frame of the ith step, in the mapping, as a cube_t argument.
+static inline cube_size_t (*anim_frame(const anim_t* anim, uint32_t i))[CUBE_SIZE] {
+  return anim->frames[anim->index[i].frame];
+}
+
+// anim_duration returns the display time (usec) of the ith step.
+static inline uint32_t anim_duration(const anim_t* anim, uint32_t i) {
+  return anim->index[i].duration_us;
+}
+
+// Writer, used to bake animations.
+typedef struct {
+    FILE*           file;
+    cube_t*         frames;   // Distinct frames so far.
+    uint32_t        frames_count;
+    uint32_t        frames_cap;
+    anim_entry*     index;
+    uint32_t        entries;
+    uint32_t        entries_cap;
+    uint32_t*       table;    // Open addressing hash table of frames + 1, 0 being empty.
+    uint32_t        table_size;
+    uint64_t        duration_us;
+}                   anim_writer;
+
+int     anim_writer_open(anim_writer* writer, const char* path);
+int     anim_writer_add(anim_writer* writer, cube_t frame, uint32_t duration_us);
+int     anim_writer_close(anim_writer* writer);
+
+#endif /* !__ANIM_H__ */
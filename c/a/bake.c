@@ -0,0 +1,235 @@
+#define _DEFAULT_SOURCE // For getopt(3) & sysconf(3) (fix warning on linux).
+#include <errno.h>      // errno(3).
+#include <pthread.h>    // pthread_create(3) & co.
+#include <stdio.h>      // fprintf(3), perror(3).
+#include <stdlib.h>     // strtoul(3), realloc(3), free(3).
+#include <string.h>     // memset(3), memcpy(3), strchr(3).
+#include <unistd.h>     // getopt(3), sysconf(3).
+
+#include "anim.h"       // Baked animations.
+#include "clock.h"      // Monotonic clock.
+#include "cube.h"       // Cube managment.
+#include "kernels.h"    // Cube kernels.
+#include "scenes.h"     // Scenes.
+
+/**
+   bake renders a show offline, as a baked animation to play with cube -p.
+
+   The show is a list of segments, each a scene played for some time from a cleared
+   cube with its own seed. Segments don't share any state, so they render in parallel
+   on all the cores, as fast as the scenes step, then get written in order.
+*/
+
+// Maximum number of segments in a show.
+#define BAKE_MAX_SEGMENTS 1024
+
+typedef struct {
+  const scene_desc*     scene;
+  uint64_t              duration_us;
+  unsigned int          seed;
+
+  // Rendered steps.
+  cube_t*               frames;
+  uint32_t*             durations;
+  uint32_t              count;
+  uint32_t              cap;
+  int                   ret;
+}                       segment_t;
+
+static segment_t        segments[BAKE_MAX_SEGMENTS];
+static unsigned int     segment_count;
+
+// Next segment to render, shared by the workers.
+static unsigned int     next_segment;
+
+// push_step appends a frame to the segment, or stretches the previous one if unchanged.
+static int      push_step(segment_t* segment, cube_t cube, uint32_t duration_us, int changed) {
+  uint32_t      n;
+  void*         p;
+
+  if (!changed && segment->count && segment->durations[segment->count - 1] <= UINT32_MAX - duration_us) {
+    segment->durations[segment->count - 1] += duration_us;
+    return 0;
+  }
+  if (segment->count == segment->cap) {
+    n = segment->cap ? segment->cap * 2 : 1024;
+    if (!(p = realloc(segment->frames, n * sizeof(cube_t)))) {
+      return -1;
+    }
+    segment->frames = p;
+    if (!(p = realloc(segment->durations, n * sizeof(uint32_t)))) {
+      return -1;
+    }
+    segment->durations = p;
+    segment->cap       = n;
+  }
+  memcpy(segment->frames[segment->count], cube, sizeof(cube_t));
+  segment->durations[segment->count++] = duration_us;
+  return 0;
+}
+
+// render_segment steps the scene of the segment until its end.
+// The last step is cut to end on time.
+static int              render_segment(segment_t* segment) {
+  scene_t               scene;
+  cube_t                cube;
+  uint64_t              elapsed = 0;
+  unsigned long         generation;
+  long                  delay;
+
+  memset(&scene, 0, sizeof(scene));
+  rng_seed(&scene.rng, segment->seed);
+  clear_cube(cube);
+
+  while (elapsed < segment->duration_us) {
+    generation = cube_generation();
+    if ((delay = segment->scene->step(&scene, cube)) < 1) {
+      delay = 1;
+    }
+    if ((uint64_t)delay > segment->duration_us - elapsed) {
+      delay = segment->duration_us - elapsed;
+    }
+    if (push_step(segment, cube, delay, cube_generation() != generation) < 0) {
+      return -1;
+    }
+    elapsed += delay;
+  }
+  return 0;
+}
+
+// worker renders segments until none is left.
+static void*    worker(void* arg) {
+  unsigned int  i;
+
+  (void)arg;
+  while ((i = __atomic_fetch_add(&next_segment, 1, __ATOMIC_RELAXED)) < segment_count) {
+    segments[i].ret = render_segment(&segments[i]);
+  }
+  return NULL;
+}
+
+// parse_segment reads a scene:seconds[:seed] segment.
+static int      parse_segment(segment_t* segment, char* arg, unsigned int seed) {
+  char*         seconds;
+  char*         end;
+
+  if (!(seconds = strchr(arg, ':'))) {
+    return -1;
+  }
+  *seconds++ = 0;
+  if (!(segment->scene = scene_lookup(arg))) {
+    return -1;
+  }
+  segment->duration_us = strtoul(seconds, &end, 10) * 1000000ULL;
+  segment->seed        = *end == ':' ? strtoul(end + 1, &end, 10) : seed;
+  return !*end && segment->duration_us ? 0 : -1;
+}
+
+static void     usage(const char* name) {
+  fprintf(stderr, "usage: %s [-j jobs] [-s seed] -o file scene:seconds[:seed]...\n", name);
+  fprintf(stderr, "  -j jobs       Render on jobs threads (default: all the cores).\n");
+  fprintf(stderr, "  -s seed       Seed of the first segment, the next ones get the next seeds (default 1).\n");
+  fprintf(stderr, "  -o file       Baked animation to write.\n");
+  fprintf(stderr, "scenes:");
+  for (const scene_desc* scene = scenes_all; scene->name; scene++) {
+    fprintf(stderr, " %s", scene->name);
+  }
+  fprintf(stderr, ".\n");
+}
+
+int             main(int argc, char** argv) {
+  const char*   output = NULL;
+  long          jobs   = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned int  seed   = 1;
+  pthread_t     threads[256];
+  anim_writer   writer;
+  uint64_t      start;
+  uint64_t      rendered;
+  uint64_t      duration_us = 0;
+  uint64_t      steps = 0;
+  int           opt;
+  int           ret;
+
+  while ((opt = getopt(argc, argv, "j:s:o:")) != -1) {
+    switch (opt) {
+    case 'j':
+      jobs = atoi(optarg);
+      break;
+    case 's':
+      seed = strtoul(optarg, NULL, 10);
+      break;
+    case 'o':
+      output = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (!output || optind == argc || argc - optind > BAKE_MAX_SEGMENTS) {
+    usage(argv[0]);
+    return 1;
+  }
+  for (int i = optind; i < argc; i++, segment_count++) {
+    if (parse_segment(&segments[segment_count], argv[i], seed + segment_count) < 0) {
+      fprintf(stderr, "invalid segment: %s\n", argv[i]);
+      usage(argv[0]);
+      return 1;
+    }
+    duration_us += segments[segment_count].duration_us;
+  }
+  if (jobs < 1) {
+    jobs = 1;
+  }
+  if (jobs > (long)(sizeof(threads) / sizeof(threads[0]))) {
+    jobs = sizeof(threads) / sizeof(threads[0]);
+  }
+
+  // Select the cube kernels, there is no hardware mapping to check.
+  cube_kernels_init(NULL);
+
+  // Render the segments on all the workers.
+  start = clock_now_ns();
+  for (long i = 0; i < jobs; i++) {
+    if ((ret = pthread_create(&threads[i], NULL, worker, NULL))) {
+      fprintf(stderr, "error starting worker: %s\n", strerror(ret));
+      return 1;
+    }
+  }
+  for (long i = 0; i < jobs; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  rendered = clock_now_ns();
+
+  // Write them in order.
+  if (anim_writer_open(&writer, output) < 0) {
+    perror(output);
+    return 1;
+  }
+  for (unsigned int i = 0; i < segment_count; i++) {
+    if (segments[i].ret < 0) {
+      fprintf(stderr, "error rendering segment %u: %s\n", i, strerror(ENOMEM));
+      return 1;
+    }
+    for (uint32_t j = 0; j < segments[i].count; j++) {
+      if (anim_writer_add(&writer, segments[i].frames[j], segments[i].durations[j]) < 0) {
+        perror(output);
+        return 1;
+      }
+    }
+    steps += segments[i].count;
+    free(segments[i].frames);
+    free(segments[i].durations);
+  }
+  fprintf(stderr, "%s: %u segments, %llu steps, %u frames, %u entries\n",
+          output, segment_count, (unsigned long long)steps, writer.frames_count, writer.entries);
+  if (anim_writer_close(&writer) < 0) {
+    perror(output);
+    return 1;
+  }
+
+  fprintf(stderr, "%s: %.1f s of show baked in %.3f s (rendered in %.3f s on %ld threads), %.0fx real time\n",
+          output, duration_us / 1e6, (clock_now_ns() - start) / 1e9, (rendered - start) / 1e9, jobs,
+          duration_us * 1e3 / (clock_now_ns() - start));
+  return 0;
+}
@@ -0,0 +1,575 @@
+#define _GNU_SOURCE             // For syscall(2) (fix warning on linux).
+#include <fcntl.h>              // open(2).
+#include <linux/perf_event.h>   // perf_event_open(2).
+#include <stdio.h>              // printf(3), fprintf(3), perror(3).
+#include <stdlib.h>             // strtoul(3), rand(3), rand_r(3).
+#include <string.h>             // memset(3), strcmp(3), strstr(3).
+#include <sys/syscall.h>        // SYS_perf_event_open.
+#include <unistd.h>             // getopt(3), dup(2), close(2).
+#if defined(__x86_64__) || defined(__i386__)
+# include <x86intrin.h>         // __rdtsc.
+#endif
+
+#include "clock.h"              // Monotonic clock.
+#include "cube.h"               // Cube managment.
+#include "gray.h"               // Grayscale cube.
+#include "kernels.h"            // Cube kernels.
+#include "remap.h"              // Hardware mapping.
+#include "rng.h"                // Scene random generator.
+#include "scenes.h"             // Scenes.
+#include "spi.h"                // SPI lib.
+#include "spi_sim.h"            // SPI emulator.
+#include "stats.h"              // Latency histograms.
+
+/**
+   cubebench times the core operations, the render path against the SPI emulator
+   and the step of each scene.
+
+   Each benchmark runs for at least the given time, doubling its iterations, and
+   keeps the best of a few runs. Results go to stdout, one tab separated line per
+   benchmark after a '#' comment header naming the format version, the kernels and
+   the cycle counter, so runs can be diffed and tracked between releases:
+
+   # cubebench 1 kernels=avx2 cycles=perf
+   name       iterations  ns/op  frames/s   cycles/op
+   set_voxel  8388608     6.63   1.508e+08  13.3
+
+   send_<transport>:<device> sends the same packed frame with each SPI transport given with -x,
+   without hold time, so the transports of a board can be compared; file to /dev/null
+   and the emulator are always run. send_layers_<transport>:<device> and render_layers
+   send it one message per layer instead, the path before whole frame messages.
+
+   cycles/op is read from the CPU cycle counter with perf_event_open(2), the time
+   stamp counter on x86 if not permitted, and is 0 if neither is available.
+*/
+
+// Version of the output format, bumped on incompatible changes.
+#define BENCH_FORMAT 1
+
+// Number of runs of each benchmark, the best one being kept.
+#define BENCH_RUNS 3
+
+// The wiring of loop.c, so the remap runs the same kernels as on the cube.
+static const int x_map[CUBE_SIZE][CUBE_SIZE] = {{0,1,2,3,4,5,6,7}, {7,6,5,4,3,2,1,0}, {0,1,2,3,4,5,6,7}, {7,6,5,4,3,2,1,0}, {0,1,2,3,4,5,6,7}, {7,6,5,4,3,2,1,0}, {0,1,2,3,4,5,6,7}, {7,6,5,4,3,2,1,0}};
+static const int y_map[CUBE_SIZE][CUBE_SIZE] = {{0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}};
+static const int z_map[CUBE_SIZE][CUBE_SIZE] = {{1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}};
+
+// State shared by the benchmarks.
+static remap_t          remap;
+static spi_handler      hdlr;
+static cube_t           cube;
+static cube_t           mapped_cube;
+static cube_size_t      tx[CUBE_SIZE + 1][CUBE_SIZE + 1]; // Layer words, then the blank word.
+static uint16_t         tx_holds[CUBE_SIZE + 1];
+static gray_t           gray;
+static scene_t          scene;
+static const scene_desc* scene_desc_run;
+static spi_handler*     send_hdlr;
+static stats_hist       hist;
+static unsigned int     seed;
+static rng_t            rng;
+
+// escape keeps the compiler from optimizing the cube writes away.
+#define escape(p) __asm__ volatile("" : : "r"(p) : "memory")
+
+// Benchmarked operations, each running n iterations.
+
+static void     bench_set_voxel(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    set_voxel(cube, i & 7, (i >> 3) & 7, (i >> 6) & 7);
+    escape(cube);
+  }
+}
+
+static void     bench_clear_cube(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    clear_cube(cube);
+    escape(cube);
+  }
+}
+
+#define BENCH_SHIFT(dir)                                \
+  static void     bench_shift_##dir(unsigned long n) {  \
+    for (unsigned long i = 0; i < n; i++) {             \
+      shift(cube, shift##dir);                          \
+      escape(cube);                                     \
+    }                                                   \
+  }
+BENCH_SHIFT(PosX)
+BENCH_SHIFT(NegX)
+BENCH_SHIFT(PosY)
+BENCH_SHIFT(NegY)
+BENCH_SHIFT(PosZ)
+BENCH_SHIFT(NegZ)
+
+#define BENCH_SET_PLANE(a)                                      \
+  static void     bench_set_plane_##a(unsigned long n) {        \
+    for (unsigned long i = 0; i < n; i++) {                     \
+      set_plane(cube, axis##a, i & 7);                          \
+      escape(cube);                                             \
+    }                                                           \
+  }
+BENCH_SET_PLANE(X)
+BENCH_SET_PLANE(Y)
+BENCH_SET_PLANE(Z)
+
+// Compose into the cube, so the OR and AND fill and empty it as scenes do.
+#define BENCH_COMPOSE(op)                                       \
+  static void     bench_compose_##op(unsigned long n) {         \
+    for (unsigned long i = 0; i < n; i++) {                     \
+      compose_cube(cube, cube, mapped_cube, compose##op);       \
+      escape(cube);                                             \
+    }                                                           \
+  }
+BENCH_COMPOSE(Or)
+BENCH_COMPOSE(And)
+BENCH_COMPOSE(Xor)
+BENCH_COMPOSE(AndNot)
+
+static void     bench_count_voxels(unsigned long n) {
+  unsigned int  count = 0;
+
+  for (unsigned long i = 0; i < n; i++) {
+    escape(cube);
+    count += count_voxels(cube);
+  }
+  escape(&count);
+}
+
+static void     bench_map_cube(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    remap_apply(&remap, cube, mapped_cube);
+    escape(mapped_cube);
+  }
+}
+
+// bench_render_cube maps, packs and sends a whole frame ending with the blank word, as loop.c
+// pack_cube and send_bus do for a single cube, the emulator not waiting for the modeled wire time.
+static void     bench_render_cube(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    remap_apply(&remap, cube, mapped_cube);
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      tx[y][0] = 0x01 << y;
+      memcpy(&tx[y][1], mapped_cube[CUBE_SIZE - 1 - y], CUBE_SIZE);
+    }
+    if (spi_transfer_frame_hold(&hdlr, tx, sizeof(tx[0]), CUBE_SIZE + 1, tx_holds) < 0) {
+      perror("spi_transfer_frame");
+      exit(1);
+    }
+  }
+}
+
+// bench_render_layers is bench_render_cube with one message per layer, as render_cube
+// did before the frames went in a single message, to compare both paths.
+static void     bench_render_layers(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    remap_apply(&remap, cube, mapped_cube);
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      tx[y][0] = 0x01 << y;
+      memcpy(&tx[y][1], mapped_cube[CUBE_SIZE - 1 - y], CUBE_SIZE);
+      if (spi_transfer(&hdlr, tx[y], NULL, sizeof(tx[y])) < 0) {
+        perror("spi_transfer");
+        exit(1);
+      }
+    }
+  }
+}
+
+// bench_stats_measure times an empty measure, the cost of the loop.c instrumentation.
+static void     bench_stats_measure(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    stats_stop(&hist, stats_start(&hist));
+  }
+}
+
+// Random generators: libc against the scenes one, then the rain top layer both ways:
+// the rand_r(3) loop rain had, drawing its bound again on each iteration so it made
+// 2.24 drops per layer on average, and the mask scene_rain.c writes instead.
+
+// Density of the rain mask, RAIN_DENSITY of scene_rain.c.
+#define BENCH_RAIN_DENSITY 9
+
+static void     bench_rand(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    escape(rand());
+  }
+}
+
+static void     bench_rand_r(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    escape(rand_r(&seed));
+  }
+}
+
+static void     bench_rng_next(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    escape(rng_next(&rng));
+  }
+}
+
+static void     bench_rng_below(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    escape(rng_below(&rng, 3));
+  }
+}
+
+static void     bench_rng_mask(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    escape(rng_mask(&rng, BENCH_RAIN_DENSITY));
+  }
+}
+
+static void     bench_drops_rand_r(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    for (unsigned int d = 0; d < rand_r(&seed) % CUBE_SIZE; d++) {
+      set_voxel(cube, rand_r(&seed) % CUBE_SIZE, CUBE_SIZE - 1, rand_r(&seed) % CUBE_SIZE);
+    }
+    escape(cube);
+  }
+}
+
+static void     bench_drops_mask(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    set_layer(cube, CUBE_SIZE - 1, rng_mask(&rng, BENCH_RAIN_DENSITY));
+    escape(cube);
+  }
+}
+
+// bench_send sends the packed frame with the transport of the benchmark.
+static void     bench_send(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    if (spi_transfer_frame(send_hdlr, tx, sizeof(tx[0]), CUBE_SIZE + 1) < 0) {
+      perror("spi_transfer_frame");
+      exit(1);
+    }
+  }
+}
+
+// bench_send_layers sends the packed frame one layer per message with the transport of the benchmark.
+static void     bench_send_layers(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      if (spi_transfer(send_hdlr, tx[y], NULL, sizeof(tx[y])) < 0) {
+        perror("spi_transfer");
+        exit(1);
+      }
+    }
+  }
+}
+
+static void     bench_scene(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    scene_desc_run->step(&scene, cube);
+    escape(cube);
+  }
+}
+
+static void     bench_scene_wave(unsigned long n) {
+  for (unsigned long i = 0; i < n; i++) {
+    wave(&scene, gray);
+    escape(gray);
+  }
+}
+
+typedef struct {
+    const char*         name;
+    void                (*run)(unsigned long n);
+    const scene_desc*   scene; // Scene stepped by bench_scene.
+    spi_handler*        hdlr;  // Handler used by bench_send.
+}                       bench_t;
+
+// Maximum number of transports given with -x, on top of the two built-in ones.
+#define BENCH_MAX_SENDS 8
+
+// Benchmarks, the scene ones appended from scenes_all.
+static bench_t          benches[64] = {
+  { "set_voxel",      bench_set_voxel,      NULL, NULL },
+  { "clear_cube",     bench_clear_cube,     NULL, NULL },
+  { "shift_pos_x",    bench_shift_PosX,     NULL, NULL },
+  { "shift_neg_x",    bench_shift_NegX,     NULL, NULL },
+  { "shift_pos_y",    bench_shift_PosY,     NULL, NULL },
+  { "shift_neg_y",    bench_shift_NegY,     NULL, NULL },
+  { "shift_pos_z",    bench_shift_PosZ,     NULL, NULL },
+  { "shift_neg_z",    bench_shift_NegZ,     NULL, NULL },
+  { "set_plane_x",    bench_set_plane_X,    NULL, NULL },
+  { "set_plane_y",    bench_set_plane_Y,    NULL, NULL },
+  { "set_plane_z",    bench_set_plane_Z,    NULL, NULL },
+  { "compose_or",     bench_compose_Or,     NULL, NULL },
+  { "compose_and",    bench_compose_And,    NULL, NULL },
+  { "compose_xor",    bench_compose_Xor,    NULL, NULL },
+  { "compose_and_not", bench_compose_AndNot, NULL, NULL },
+  { "count_voxels",   bench_count_voxels,   NULL, NULL },
+  { "map_cube",       bench_map_cube,       NULL, NULL },
+  { "render_cube",    bench_render_cube,    NULL, NULL },
+  { "render_layers",  bench_render_layers,  NULL, NULL },
+  { "stats_measure",  bench_stats_measure,  NULL, NULL },
+  { "rand",           bench_rand,           NULL, NULL },
+  { "rand_r",         bench_rand_r,         NULL, NULL },
+  { "rng_next",       bench_rng_next,       NULL, NULL },
+  { "rng_below",      bench_rng_below,      NULL, NULL },
+  { "rng_mask",       bench_rng_mask,       NULL, NULL },
+  { "drops_rand_r",   bench_drops_rand_r,   NULL, NULL },
+  { "drops_mask",     bench_drops_mask,     NULL, NULL },
+  { "scene_wave",     bench_scene_wave,     NULL, NULL },
+};
+
+// Cycle counter.
+
+static int      perf_fd = -1;
+
+// cycles_open opens the CPU cycle counter of the thread.
+// Returns the name of the counter used.
+static const char*              cycles_open() {
+  struct perf_event_attr        attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.type           = PERF_TYPE_HARDWARE;
+  attr.size           = sizeof(attr);
+  attr.config         = PERF_COUNT_HW_CPU_CYCLES;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  if ((perf_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0)) >= 0) {
+    return "perf";
+  }
+#if defined(__x86_64__) || defined(__i386__)
+  return "tsc";
+#else
+  return "none";
+#endif
+}
+
+// cycles_now returns the cycle count, 0 without counter.
+static uint64_t cycles_now() {
+  uint64_t      count;
+
+  if (perf_fd >= 0) {
+    return read(perf_fd, &count, sizeof(count)) == sizeof(count) ? count : 0;
+  }
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// Runner.
+
+typedef struct {
+    unsigned long   n;
+    double          ns;     // Per op.
+    double          cycles; // Per op.
+}                   result_t;
+
+// reset gives each run the same starting state.
+static void     reset(const bench_t* bench) {
+  clear_cube(cube);
+  for (unsigned int i = 0; i < CUBE_SIZE * CUBE_SIZE * CUBE_SIZE; i += 3) {
+    set_voxel(cube, i & 7, (i >> 3) & 7, (i >> 6) & 7);
+  }
+  gray_clear(gray);
+  memset(&scene, 0, sizeof(scene));
+  rng_seed(&scene.rng, 1);
+  rng_seed(&rng, 1);
+  srand(1);
+  seed           = 1;
+  scene_desc_run = bench->scene;
+  send_hdlr      = bench->hdlr;
+}
+
+// measure runs the benchmark until it lasts at least min_ns, doubling its iterations.
+static result_t measure(const bench_t* bench, uint64_t min_ns) {
+  result_t      res = { 0 };
+  uint64_t      start;
+  uint64_t      elapsed;
+  uint64_t      cycles;
+
+  for (unsigned long n = 1;; n *= 2) {
+    reset(bench);
+    cycles  = cycles_now();
+    start   = clock_now_ns();
+    bench->run(n);
+    elapsed = clock_now_ns() - start;
+    cycles  = cycles_now() - cycles;
+    if (elapsed >= min_ns || n >= (1UL << 40)) {
+      res.n      = n;
+      res.ns     = (double)elapsed / n;
+      res.cycles = (double)cycles / n;
+      return res;
+    }
+  }
+}
+
+static void     usage(const char* name) {
+  fprintf(stderr, "usage: %s [-t msec] [-k kernels] [-x transport:device]... [filter]...\n", name);
+  fprintf(stderr, "  -t msec       Minimum time of each run (default 200).\n");
+  fprintf(stderr, "  -k kernels    Cube kernels to use: scalar, sse2, avx2, neon (default: best supported).\n");
+  fprintf(stderr, "  -x transport:device  Benchmark sending frames with the SPI transport, e.g. spidev-wo:/dev/spidev0.0, up to %d.\n", BENCH_MAX_SENDS);
+  fprintf(stderr, "filter: only run the benchmarks whose name contains one of them.\n");
+}
+
+// selected tells if the benchmark matches one of the filters, if any.
+static int      selected(const char* name, int count, char** filters) {
+  for (int i = 0; i < count; i++) {
+    if (strstr(name, filters[i])) {
+      return 1;
+    }
+  }
+  return !count;
+}
+
+int                     main(int argc, char** argv) {
+  const char*           kernels = NULL;
+  const char*           sends[BENCH_MAX_SENDS + 2] = { "file:/dev/null", "sim:sim" };
+  unsigned int          send_count = 2;
+  static spi_handler    send_hdlrs[BENCH_MAX_SENDS + 2];
+  static char           names[64][64];
+  const char*           counter;
+  uint64_t              min_ns  = 200000000;
+  unsigned int          count;
+  int                   quiet;
+  int                   out;
+  int                   opt;
+
+  while ((opt = getopt(argc, argv, "t:k:x:")) != -1) {
+    switch (opt) {
+    case 't':
+      min_ns = strtoul(optarg, NULL, 10) * 1000000;
+      break;
+    case 'k':
+      kernels = optarg;
+      break;
+    case 'x':
+      if (send_count == BENCH_MAX_SENDS + 2) {
+        usage(argv[0]);
+        return 1;
+      }
+      sends[send_count++] = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  // Same setup as the cube.
+  remap_compile(&remap, x_map, y_map, z_map);
+  cube_kernels_init(&remap);
+  if (kernels) {
+    const cube_kernels_t** k;
+
+    for (k = cube_kernels_all; *k && strcmp((*k)->name, kernels); k++);
+    if (!*k || !(*k)->supported()) {
+      fprintf(stderr, "kernels %s not supported\n", kernels);
+      return 1;
+    }
+    cube_kernels = *k;
+  }
+
+  // Render against the emulator, without waiting for the modeled wire time.
+  hdlr.config.device = "sim";
+  hdlr.config.bits   = 8;
+  hdlr.config.speed  = 8000000;
+  hdlr.config.delay  = 5;
+  hdlr.transport     = &spi_sim_transport;
+  spi_sim_blocking   = 0;
+  for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+    tx_holds[y] = hdlr.config.delay;
+  }
+  if (spi_setup(&hdlr) < 0) {
+    perror("spi_setup");
+    return 1;
+  }
+
+  for (count = 0; benches[count].name; count++);
+
+  // Send a frame of the cube with each transport, as the loop.c send_bus does.
+  reset(&benches[0]);
+  remap_apply(&remap, cube, mapped_cube);
+  for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+    tx[y][0] = 0x01 << y;
+    memcpy(&tx[y][1], mapped_cube[CUBE_SIZE - 1 - y], CUBE_SIZE);
+  }
+  for (unsigned int i = 0; i < send_count; i++) {
+    spi_handler*        send = &send_hdlrs[i];
+    const char*         device = strchr(sends[i], ':');
+    char                name[32];
+
+    if (!device || (size_t)(device - sends[i]) >= sizeof(name)) {
+      usage(argv[0]);
+      return 1;
+    }
+    memcpy(name, sends[i], device - sends[i]);
+    name[device - sends[i]] = 0;
+    if (!(send->transport = spi_transport_lookup(name))) {
+      fprintf(stderr, "unknown SPI transport: %s\n", name);
+      return 1;
+    }
+    send->config       = hdlr.config;
+    send->config.delay = 0;
+    send->config.device = device + 1;
+    if (spi_setup(send) < 0) {
+      perror(sends[i]);
+      return 1;
+    }
+    snprintf(names[count], sizeof(names[count]), "send_%s", sends[i]);
+    benches[count].name = names[count];
+    benches[count].run  = bench_send;
+    benches[count].hdlr = send;
+    count++;
+    snprintf(names[count], sizeof(names[count]), "send_layers_%s", sends[i]);
+    benches[count].name = names[count];
+    benches[count].run  = bench_send_layers;
+    benches[count].hdlr = send;
+    count++;
+  }
+
+  for (const scene_desc* desc = scenes_all; desc->name; desc++) {
+    snprintf(names[count], sizeof(names[count]), "scene_%s", desc->name);
+    benches[count].name  = names[count];
+    benches[count].run   = bench_scene;
+    benches[count].scene = desc;
+    count++;
+  }
+
+  counter = cycles_open();
+  printf("# cubebench %d kernels=%s cycles=%s\n", BENCH_FORMAT, cube_kernels->name, counter);
+  printf("name\titerations\tns/op\tframes/s\tcycles/op\n");
+  fflush(stdout);
+
+  // The manual scene traces its voxel on stdout, keep it out of the results.
+  quiet = open("/dev/null", O_WRONLY);
+  out   = dup(STDOUT_FILENO);
+
+  for (unsigned int i = 0; i < count; i++) {
+    result_t    best = { 0 };
+    result_t    res;
+
+    if (!selected(benches[i].name, argc - optind, argv + optind)) {
+      continue;
+    }
+    dup2(quiet, STDOUT_FILENO);
+    for (int r = 0; r < BENCH_RUNS; r++) {
+      res = measure(&benches[i], min_ns);
+      if (!r || res.ns < best.ns) {
+        best = res;
+      }
+    }
+    fflush(stdout);
+    dup2(out, STDOUT_FILENO);
+    printf("%s\t%lu\t%.2f\t%.4g\t%.1f\n", benches[i].name, best.n, best.ns, 1e9 / best.ns, best.cycles);
+    fflush(stdout);
+  }
+
+  close(quiet);
+  close(out);
+  if (perf_fd >= 0) {
+    close(perf_fd);
+  }
+
+  // The emulator reports go to stderr.
+  for (unsigned int i = 0; i < send_count; i++) {
+    spi_cleanup(&send_hdlrs[i]);
+  }
+  spi_cleanup(&hdlr);
+  return 0;
+}
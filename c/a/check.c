@@ -0,0 +1,321 @@
+#include <stdio.h>      // printf(3), fprintf(3).
+#include <string.h>     // memcmp(3), memcpy(3), memset(3).
+
+#include "cube.h"       // Cube managment.
+#include "kernels.h"    // Cube kernels.
+#include "remap.h"      // Hardware mapping.
+#include "rng.h"        // Random cubes and wirings.
+
+/**
+   cubecheck checks the compiled paths against simple models, run by make check.
+
+   remap: the compiled remap (remap_apply with the selected kernels, remap_apply_scalar
+   and remap_reference) against map_cube, the per voxel mapping loop.c used before, over
+   the loop.c wiring, the identity, reversed and random permutations on each axis, and
+   merging and non separable wirings for the fallbacks. Each voxel alone, then random cubes.
+   Every kernel set supported by the CPU gets its remap checked on each wiring.
+
+   kernels: clear, popcount, each compose op, shift in each direction and set_plane on each
+   axis and plane, of every kernel set supported by the CPU against the scalar ones, on the
+   empty, full and random cubes.
+
+   Exits 1 on the first mismatch.
+*/
+
+// Number of random cubes per check.
+#define CHECK_CUBES   256
+
+// Number of random wirings of each kind.
+#define CHECK_WIRINGS 8
+
+// The wiring of loop.c.
+static wiring_t         loop_x_map = {{0,1,2,3,4,5,6,7}, {7,6,5,4,3,2,1,0}, {0,1,2,3,4,5,6,7}, {7,6,5,4,3,2,1,0}, {0,1,2,3,4,5,6,7}, {7,6,5,4,3,2,1,0}, {0,1,2,3,4,5,6,7}, {7,6,5,4,3,2,1,0}};
+static wiring_t         loop_y_map = {{0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}};
+static wiring_t         loop_z_map = {{1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}};
+
+static rng_t            rng;
+
+// Models.
+
+// map_cube maps src to dst one voxel at the time, as loop.c did before remap_compile.
+static void     map_cube(wiring_t x_map, wiring_t y_map, wiring_t z_map, cube_t src, cube_t dst) {
+  clear_cube(dst);
+  for (unsigned int x = 0; x < CUBE_SIZE; x++) {
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      for (unsigned int z = 0; z < CUBE_SIZE; z++) {
+        if (get_voxel(src, x, y, z)) {
+          set_voxel(dst, x_map[z][x], y_map[x][y], z_map[x][z]);
+        }
+      }
+    }
+  }
+}
+
+// Helpers.
+
+// random_cube fills the cube with random voxels.
+static void     random_cube(cube_t cube) {
+  for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+    set_layer(cube, y, rng_next(&rng));
+  }
+}
+
+// random_permutation shuffles 0 to CUBE_SIZE - 1 in row.
+static void     random_permutation(int* row) {
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    row[i] = i;
+  }
+  for (unsigned int i = CUBE_SIZE - 1; i > 0; i--) {
+    unsigned int        j = rng_below(&rng, i + 1);
+    int                 t = row[i];
+
+    row[i] = row[j];
+    row[j] = t;
+  }
+}
+
+// fill_wiring sets each row of the wiring to the same row.
+static void     fill_wiring(wiring_t map, const int* row) {
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    memcpy(map[i], row, sizeof(map[i]));
+  }
+}
+
+// Checks.
+
+// check_remap_wiring compiles the wiring and checks each remap path against map_cube.
+// Returns the number of cubes checked, -1 on mismatch.
+static int      check_remap_wiring(const char* name, wiring_t x_map, wiring_t y_map, wiring_t z_map) {
+  static remap_t        remap;
+  cube_t                src;
+  cube_t                want;
+  cube_t                got;
+  int                   count = 0;
+
+  // ISO C doesn't convert to pointers to const arrays implicitly.
+  remap_compile(&remap, (const int (*)[CUBE_SIZE])x_map, (const int (*)[CUBE_SIZE])y_map, (const int (*)[CUBE_SIZE])z_map);
+  for (unsigned int i = 0; i < CUBE_SIZE * CUBE_SIZE * CUBE_SIZE + CHECK_CUBES; i++) {
+    // Each voxel alone first, then random cubes.
+    clear_cube(src);
+    if (i < CUBE_SIZE * CUBE_SIZE * CUBE_SIZE) {
+      set_voxel(src, i % CUBE_SIZE, i / CUBE_SIZE % CUBE_SIZE, i / (CUBE_SIZE * CUBE_SIZE));
+    } else {
+      random_cube(src);
+    }
+    map_cube(x_map, y_map, z_map, src, want);
+
+    remap_apply(&remap, src, got);
+    if (memcmp(got, want, sizeof(cube_t))) {
+      fprintf(stderr, "remap %s: remap_apply (%s) mismatch on cube %u\n", name, cube_kernels->name, i);
+      return -1;
+    }
+    for (const cube_kernels_t** k = cube_kernels_all; *k; k++) {
+      if (!(*k)->supported()) {
+        continue;
+      }
+      (*k)->remap(&remap, src, got);
+      if (memcmp(got, want, sizeof(cube_t))) {
+        fprintf(stderr, "remap %s: %s kernels mismatch on cube %u\n", name, (*k)->name, i);
+        return -1;
+      }
+    }
+    remap_apply_scalar(&remap, src, got);
+    if (memcmp(got, want, sizeof(cube_t))) {
+      fprintf(stderr, "remap %s: remap_apply_scalar mismatch on cube %u\n", name, i);
+      return -1;
+    }
+    remap_reference(&remap, src, got);
+    if (memcmp(got, want, sizeof(cube_t))) {
+      fprintf(stderr, "remap %s: remap_reference mismatch on cube %u\n", name, i);
+      return -1;
+    }
+    count++;
+  }
+  return count;
+}
+
+// check_remap runs check_remap_wiring over all the wirings.
+// Returns -1 on mismatch.
+static int      check_remap() {
+  static wiring_t       x_map;
+  static wiring_t       y_map;
+  static wiring_t       z_map;
+  int                   row[CUBE_SIZE];
+  unsigned int          wirings = 0;
+  int                   cubes   = 0;
+  int                   n;
+
+#define CHECK_WIRING(name, x, y, z)                                     \
+  do {                                                                  \
+    if ((n = check_remap_wiring(name, x, y, z)) < 0) {                  \
+      return -1;                                                        \
+    }                                                                   \
+    cubes += n;                                                         \
+    wirings++;                                                          \
+  } while (0)
+
+  CHECK_WIRING("loop.c", loop_x_map, loop_y_map, loop_z_map);
+
+  // Identity, then all the axes reversed.
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    row[i] = i;
+  }
+  fill_wiring(x_map, row);
+  fill_wiring(y_map, row);
+  fill_wiring(z_map, row);
+  CHECK_WIRING("identity", x_map, y_map, z_map);
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    row[i] = CUBE_SIZE - 1 - i;
+  }
+  fill_wiring(x_map, row);
+  fill_wiring(y_map, row);
+  fill_wiring(z_map, row);
+  CHECK_WIRING("reversed", x_map, y_map, z_map);
+
+  // Random permutations: a X wiring per Z, the same Y and Z wirings on each X.
+  for (unsigned int w = 0; w < CHECK_WIRINGS; w++) {
+    for (unsigned int z = 0; z < CUBE_SIZE; z++) {
+      random_permutation(x_map[z]);
+    }
+    random_permutation(row);
+    fill_wiring(y_map, row);
+    random_permutation(row);
+    fill_wiring(z_map, row);
+    CHECK_WIRING("permutation", x_map, y_map, z_map);
+  }
+
+  // Z rows merged two by two, so destination bytes have several sources.
+  for (unsigned int w = 0; w < CHECK_WIRINGS; w++) {
+    for (unsigned int z = 0; z < CUBE_SIZE; z++) {
+      random_permutation(x_map[z]);
+    }
+    random_permutation(row);
+    fill_wiring(y_map, row);
+    for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+      row[i] = i / 2;
+    }
+    fill_wiring(z_map, row);
+    CHECK_WIRING("merged", x_map, y_map, z_map);
+  }
+
+  // Y and Z wirings depending on X, so X rows get split.
+  for (unsigned int w = 0; w < CHECK_WIRINGS; w++) {
+    for (unsigned int x = 0; x < CUBE_SIZE; x++) {
+      random_permutation(x_map[x]);
+      random_permutation(y_map[x]);
+      random_permutation(z_map[x]);
+    }
+    CHECK_WIRING("split", x_map, y_map, z_map);
+  }
+
+#undef CHECK_WIRING
+
+  printf("remap: %u wirings, %d cubes ok\n", wirings, cubes);
+  return 0;
+}
+
+// check_kernels_cube checks the kernels of the set against the scalar ones on src, composing it with other.
+// Returns -1 on mismatch.
+static int                      check_kernels_cube(const cube_kernels_t* kernels, cube_t src, cube_t other, unsigned int i) {
+  const cube_kernels_t*         ref = &cube_kernels_scalar;
+  cube_t                        got;
+  cube_t                        want;
+
+  memcpy(got, src, sizeof(cube_t));
+  kernels->clear(got);
+  memset(want, 0, sizeof(cube_t));
+  if (memcmp(got, want, sizeof(cube_t))) {
+    fprintf(stderr, "kernels %s: clear mismatch on cube %u\n", kernels->name, i);
+    return -1;
+  }
+
+  if (kernels->popcount(src) != ref->popcount(src)) {
+    fprintf(stderr, "kernels %s: popcount %u, expected %u on cube %u\n", kernels->name, kernels->popcount(src), ref->popcount(src), i);
+    return -1;
+  }
+
+  for (compose_op_t op = composeOr; op <= composeAndNot; op++) {
+    memset(got, 0x5a, sizeof(cube_t));
+    memset(want, 0xa5, sizeof(cube_t));
+    kernels->compose(got, src, other, op);
+    ref->compose(want, src, other, op);
+    if (memcmp(got, want, sizeof(cube_t))) {
+      fprintf(stderr, "kernels %s: compose %d mismatch on cube %u\n", kernels->name, op, i);
+      return -1;
+    }
+    // In place, as scenes compose into one of their operands.
+    memcpy(got, src, sizeof(cube_t));
+    kernels->compose(got, got, other, op);
+    if (memcmp(got, want, sizeof(cube_t))) {
+      fprintf(stderr, "kernels %s: compose %d in place mismatch on cube %u\n", kernels->name, op, i);
+      return -1;
+    }
+  }
+
+  for (shift_dir_t dir = shiftPosX; dir <= shiftNegZ; dir++) {
+    memcpy(got, src, sizeof(cube_t));
+    memcpy(want, src, sizeof(cube_t));
+    kernels->shift(got, dir);
+    ref->shift(want, dir);
+    if (memcmp(got, want, sizeof(cube_t))) {
+      fprintf(stderr, "kernels %s: shift %d mismatch on cube %u\n", kernels->name, dir, i);
+      return -1;
+    }
+  }
+
+  for (axis_t axis = axisX; axis <= axisZ; axis++) {
+    for (unsigned int n = 0; n < CUBE_SIZE; n++) {
+      memcpy(got, src, sizeof(cube_t));
+      memcpy(want, src, sizeof(cube_t));
+      kernels->set_plane(got, axis, n);
+      ref->set_plane(want, axis, n);
+      if (memcmp(got, want, sizeof(cube_t))) {
+        fprintf(stderr, "kernels %s: set_plane %d %u mismatch on cube %u\n", kernels->name, axis, n, i);
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+// check_kernels runs check_kernels_cube for each supported kernel set.
+// Returns -1 on mismatch.
+static int      check_kernels() {
+  cube_t        src;
+  cube_t        other;
+  unsigned int  sets = 0;
+
+  for (const cube_kernels_t** k = cube_kernels_all; *k; k++) {
+    if (!(*k)->supported()) {
+      fprintf(stderr, "kernels %s: not supported, skipped\n", (*k)->name);
+      continue;
+    }
+    for (unsigned int i = 0; i < CHECK_CUBES + 2; i++) {
+      // Empty and full cubes first, then random cubes.
+      if (i < 2) {
+        memset(src, i ? 0xff : 0, sizeof(cube_t));
+      } else {
+        random_cube(src);
+      }
+      random_cube(other);
+      if (check_kernels_cube(*k, src, other, i) < 0) {
+        return -1;
+      }
+    }
+    printf("kernels %s: %d cubes ok\n", (*k)->name, CHECK_CUBES + 2);
+    sets++;
+  }
+  printf("kernels: %u sets ok\n", sets);
+  return 0;
+}
+
+int     main() {
+  int   ret = 0;
+
+  rng_seed(&rng, 1);
+  cube_kernels_init(NULL);
+
+  ret |= check_kernels();
+  ret |= check_remap();
+  return ret < 0 ? 1 : 0;
+}
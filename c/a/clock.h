@@ -0,0 +1,30 @@
+#ifndef __CLOCK_H__
+# define __CLOCK_H__
+
+# include <stdint.h> // uint64_t.
+# include <time.h>   // clock_gettime(2), clock_nanosleep(2).
+
+// Monotonic clock helpers, times in nsec.
+
+# define NSEC_PER_SEC 1000000000ULL
+
+// clock_now_ns returns the current monotonic time.
+static inline uint64_t  clock_now_ns() {
+  struct timespec       ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+// clock_sleep_until sleeps until the given monotonic time.
+// Returns 0 once reached, EINTR if interrupted by a signal handler.
+static inline int       clock_sleep_until(uint64_t ns) {
+  struct timespec       ts = {
+    .tv_sec  = ns / NSEC_PER_SEC,
+    .tv_nsec = ns % NSEC_PER_SEC,
+  };
+
+  return clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+#endif /* !__CLOCK_H__ */
@@ -1,11 +1,19 @@
 #ifndef __CUBE_H__
 # define __CUBE_H__
 
+# include <stdint.h> // uint64_t.
+# include <string.h> // memcpy(3).
+
 // Define the cube as 8x8x8, one color.
 typedef unsigned char cube_size_t;                  // 8 bits per element.
 #define CUBE_SIZE     (sizeof(cube_size_t) * 8)
 typedef cube_size_t   cube_t[CUBE_SIZE][CUBE_SIZE]; // 2d array so we have x*y*z.
 
+// Each Y layer of the cube, all of X*Z, as a 64 bits bitboard: bit (CUBE_SIZE - 1 - z) * 8 + x.
+// It is the cube[CUBE_SIZE - 1 - y] row read as a little-endian word, so converting
+// to and from the render format is a single load or store.
+typedef uint64_t      cube_layer_t;
+
 // Enum for shift direction.
 typedef enum {
               shiftPosX,
@@ -23,9 +31,47 @@ typedef enum {
               axisZ,
 } axis_t;
 
+// Enum for bitwise compose of two cubes.
+typedef enum {
+              composeOr,     // a | b.
+              composeAnd,    // a & b.
+              composeXor,    // a ^ b.
+              composeAndNot, // a & ~b.
+} compose_op_t;
+
+// cube_get_layer returns the Y layer y as a bitboard.
+static inline cube_layer_t cube_get_layer(cube_t cube, int y) {
+  cube_layer_t  layer;
+
+  memcpy(&layer, cube[CUBE_SIZE - 1 - y], sizeof(layer));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  layer = __builtin_bswap64(layer);
+#endif
+  return layer;
+}
+
+// cube_put_layer stores the bitboard as the Y layer y, without bumping the generation.
+static inline void cube_put_layer(cube_t cube, int y, cube_layer_t layer) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  layer = __builtin_bswap64(layer);
+#endif
+  memcpy(cube[CUBE_SIZE - 1 - y], &layer, sizeof(layer));
+}
+
+// get_voxel checks if a point is on or off in the cube.
+static inline int get_voxel(cube_t cube, int x, int y, int z) {
+  return (cube[CUBE_SIZE - 1 - y][CUBE_SIZE - 1 - z] >> x) & 0x01;
+}
+
+unsigned long cube_generation();
+
 void set_voxel(cube_t cube, int x, int y, int z);
+void clear_voxel(cube_t cube, int x, int y, int z);
 void clear_cube(cube_t cube);
 void shift(cube_t cube, shift_dir_t dir);
 void set_plane(cube_t cube, axis_t axis, int i);
+void set_layer(cube_t cube, int y, cube_layer_t layer);
+void compose_cube(cube_t dst, cube_t a, cube_t b, compose_op_t op);
+unsigned int count_voxels(cube_t cube);
 
 #endif /* !__CUBE_H__ */
@@ -0,0 +1,180 @@
+#define _DEFAULT_SOURCE // For getopt(3) (fix warning on linux).
+#include <fcntl.h>      // open(2).
+#include <stdio.h>      // fprintf(3), perror(3), fwrite(3).
+#include <stdlib.h>     // strtoull(3), strtod(3).
+#include <string.h>     // strcmp(3).
+#include <unistd.h>     // getopt(3), dup(2), dup2(2), close(2).
+
+#include "clock.h"      // Monotonic clock.
+#include "cube.h"       // Cube managment.
+#include "kernels.h"    // Cube kernels.
+#include "scenes.h"     // Scenes.
+
+/**
+   cubesim steps a scene headless, as fast as it goes, on a simulated clock: each
+   step advances the clock by the delay the scene asked for instead of sleeping it.
+   No SPI device nor refresh thread, so scenes can be profiled and checked on any box.
+
+   Default seed is 1, so runs are reproducible. Output is one of:
+     - none:  the summary only,
+     - hash:  one "step<TAB>time_us<TAB>hash" line per step, the golden data to diff,
+     - raw:   the frames, one cube_t (64 bytes) per step.
+
+   The summary, on stderr, ends with the digest of the whole run, chaining the hash
+   of each frame, so a scene change is checked against a known run with one line:
+
+   $> ./cubesim -n 1000000 -s 42 rain
+   rain: 1000000 steps, 60000.0 s simulated in 0.184 s, 5.43e+06 steps/s, 3.26e+05x real time
+   rain: digest e2fb4f50cff2caba
+*/
+
+// Output formats.
+typedef enum {
+  formatNone,
+  formatHash,
+  formatRaw,
+}                       format_t;
+
+// Hash constants (64 bits FNV-1a, then the SplitMix64 finalizer).
+#define HASH_OFFSET 0xcbf29ce484222325ULL
+#define HASH_PRIME  0x100000001b3ULL
+
+// mix spreads the bits of h over the whole word.
+static uint64_t mix(uint64_t h) {
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+// frame_hash hashes the cube a layer at a time, so equal frames hash the same on any host.
+static uint64_t frame_hash(cube_t cube) {
+  uint64_t      h = HASH_OFFSET;
+
+  for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+    h = (h ^ cube_get_layer(cube, y)) * HASH_PRIME;
+  }
+  return mix(h);
+}
+
+static void     usage(const char* name) {
+  fprintf(stderr, "usage: %s [-n steps] [-d seconds] [-s seed] [-f format] [-c] [-o file] scene\n", name);
+  fprintf(stderr, "  -n steps      Stop after steps (default 1000000).\n");
+  fprintf(stderr, "  -d seconds    Stop after seconds of simulated time, whichever first.\n");
+  fprintf(stderr, "  -s seed       Seed of the scene (default 1).\n");
+  fprintf(stderr, "  -f format     Output: none (default), hash or raw.\n");
+  fprintf(stderr, "  -c            Only output the steps changing the frame.\n");
+  fprintf(stderr, "  -o file       Output file (default stdout).\n");
+  fprintf(stderr, "scenes:");
+  for (const scene_desc* scene = scenes_all; scene->name; scene++) {
+    fprintf(stderr, " %s", scene->name);
+  }
+  fprintf(stderr, ".\n");
+}
+
+int                     main(int argc, char** argv) {
+  const scene_desc*     desc;
+  const char*           output  = NULL;
+  uint64_t              steps   = 1000000;
+  uint64_t              max_us  = UINT64_MAX;
+  uint64_t              seed    = 1;
+  format_t              format  = formatNone;
+  int                   changes = 0;
+  static char           buf[1 << 16];
+  static scene_t        scene;
+  cube_t                cube;
+  FILE*                 out;
+  uint64_t              now_us  = 0;
+  uint64_t              digest  = HASH_OFFSET;
+  uint64_t              hash;
+  uint64_t              start;
+  uint64_t              elapsed;
+  uint64_t              step;
+  unsigned long         generation;
+  int                   quiet;
+  int                   opt;
+
+  while ((opt = getopt(argc, argv, "n:d:s:f:co:")) != -1) {
+    switch (opt) {
+    case 'n':
+      steps = strtoull(optarg, NULL, 10);
+      break;
+    case 'd':
+      max_us = strtod(optarg, NULL) * 1e6;
+      break;
+    case 's':
+      seed = strtoull(optarg, NULL, 10);
+      break;
+    case 'f':
+      if (!strcmp(optarg, "none")) {
+        format = formatNone;
+      } else if (!strcmp(optarg, "hash")) {
+        format = formatHash;
+      } else if (!strcmp(optarg, "raw")) {
+        format = formatRaw;
+      } else {
+        usage(argv[0]);
+        return 1;
+      }
+      break;
+    case 'c':
+      changes = 1;
+      break;
+    case 'o':
+      output = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (argc - optind != 1 || !(desc = scene_lookup(argv[optind]))) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  // The manual scene traces its voxel on stdout, keep it out of the output.
+  if (!(out = output ? fopen(output, "w") : fdopen(dup(STDOUT_FILENO), "w"))) {
+    perror(output ? output : "stdout");
+    return 1;
+  }
+  setvbuf(out, buf, _IOFBF, sizeof(buf));
+  if ((quiet = open("/dev/null", O_WRONLY)) < 0 || dup2(quiet, STDOUT_FILENO) < 0) {
+    perror("/dev/null");
+    return 1;
+  }
+  close(quiet);
+
+  // Select the cube kernels, there is no hardware mapping to check.
+  cube_kernels_init(NULL);
+  rng_seed(&scene.rng, seed);
+  clear_cube(cube);
+
+  start = clock_now_ns();
+  for (step = 0; step < steps && now_us < max_us; step++) {
+    generation = cube_generation();
+    now_us    += desc->step(&scene, cube);
+    hash       = frame_hash(cube);
+    digest     = (digest ^ hash) * HASH_PRIME;
+
+    if (format == formatNone || (changes && generation == cube_generation())) {
+      continue;
+    }
+    if (format == formatHash) {
+      fprintf(out, "%llu\t%llu\t%016llx\n",
+              (unsigned long long)step, (unsigned long long)now_us, (unsigned long long)hash);
+    } else if (fwrite(cube, sizeof(cube_t), 1, out) != 1) {
+      break;
+    }
+  }
+  elapsed = clock_now_ns() - start;
+
+  if (fclose(out) == EOF) {
+    perror(output ? output : "stdout");
+    return 1;
+  }
+  fprintf(stderr, "%s: %llu steps, %.1f s simulated in %.3f s, %.3g steps/s, %.3gx real time\n",
+          desc->name, (unsigned long long)step, now_us / 1e6, elapsed / 1e9,
+          step * 1e9 / (elapsed ? elapsed : 1), now_us * 1e3 / (elapsed ? elapsed : 1));
+  fprintf(stderr, "%s: digest %016llx\n", desc->name, (unsigned long long)mix(digest));
+  return 0;
+}
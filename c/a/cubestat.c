@@ -0,0 +1,65 @@
+#define _DEFAULT_SOURCE // For getopt(3) (fix warning on linux).
+#include <signal.h>     // signal(2).
+#include <stdio.h>      // printf(3), perror(3).
+#include <stdlib.h>     // strtoul(3).
+#include <unistd.h>     // getopt(3), sleep(3).
+
+#include "clock.h"      // Monotonic clock.
+#include "stats.h"      // Latency histograms.
+
+/**
+   cubestat prints the latency histograms a cube publishes with -s, without
+   disturbing it: the shared memory object is mapped read only.
+
+   Each histogram is a line of tab separated values in usec, after a header line:
+   count, min, mean, p50, p90, p99, p99.9 and max.
+*/
+
+static volatile int _running = 1;
+
+static void intHandler() {
+    _running = 0;
+}
+
+static void     usage(const char* name) {
+  fprintf(stderr, "usage: %s [-i seconds] name\n", name);
+  fprintf(stderr, "  -i seconds    Print the histograms again every seconds, until SIGINT.\n");
+}
+
+int             main(int argc, char** argv) {
+  stats_t       stats;
+  unsigned int  interval = 0;
+  int           opt;
+
+  while ((opt = getopt(argc, argv, "i:")) != -1) {
+    switch (opt) {
+    case 'i':
+      interval = strtoul(optarg, NULL, 10);
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (optind + 1 != argc) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (stats_open(&stats, argv[optind]) < 0) {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  signal(SIGINT, intHandler);
+  signal(SIGTERM, intHandler);
+
+  do {
+    printf("# %s, up %.1f s\n", argv[optind], (clock_now_ns() - stats.header->start_ns) / 1e9);
+    stats_print(&stats, stdout);
+    fflush(stdout);
+  } while (interval && !sleep(interval) && _running);
+
+  stats_close(&stats);
+  return 0;
+}
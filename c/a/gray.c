@@ -0,0 +1,43 @@
+#include <string.h> // memset(3).
+
+#include "gray.h"
+
+// gray_clear turns off the whole cube.
+void    gray_clear(gray_t gray) {
+  memset(gray, 0, sizeof(gray_t));
+}
+
+// gray_set_voxel sets the intensity of the x*y*z LED.
+void    gray_set_voxel(gray_t gray, int x, int y, int z, uint8_t level) {
+  gray[CUBE_SIZE - 1 - y][CUBE_SIZE - 1 - z][x] = level;
+}
+
+// transpose8 transposes the 8x8 bit matrix held in x, byte i being row i.
+static inline uint64_t  transpose8(uint64_t x) {
+  uint64_t              t;
+
+  t = (x ^ (x >> 7))  & 0x00AA00AA00AA00AAULL; x ^= t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL; x ^= t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL; x ^= t ^ (t << 28);
+  return x;
+}
+
+// gray_decompose splits the bits most significant bits of each intensity into bit-planes.
+// planes[0] holds the least significant of them, planes[bits - 1] the most significant.
+void            gray_decompose(gray_t gray, int bits, cube_t planes[]) {
+  uint64_t      row;
+
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    for (unsigned int j = 0; j < CUBE_SIZE; j++) {
+      // Byte x of the row is the intensity of voxel x, once transposed, byte b holds bit b of each voxel.
+      row = 0;
+      for (unsigned int x = 0; x < CUBE_SIZE; x++) {
+        row |= (uint64_t)gray[i][j][x] << (x * 8);
+      }
+      row = transpose8(row);
+      for (int b = 0; b < bits; b++) {
+        planes[b][i][j] = row >> ((8 - bits + b) * 8);
+      }
+    }
+  }
+}
@@ -0,0 +1,18 @@
+#ifndef __GRAY_H__
+# define __GRAY_H__
+
+# include <stdint.h> // uint8_t.
+
+# include "cube.h"   // cube_t.
+
+// Maximum bits per voxel displayed with binary code modulation.
+# define GRAY_MAX_BITS 6
+
+// Grayscale cube, one 0-255 intensity per voxel, indexed [CUBE_SIZE - 1 - y][CUBE_SIZE - 1 - z][x].
+typedef uint8_t gray_t[CUBE_SIZE][CUBE_SIZE][CUBE_SIZE];
+
+void    gray_clear(gray_t gray);
+void    gray_set_voxel(gray_t gray, int x, int y, int z, uint8_t level);
+void    gray_decompose(gray_t gray, int bits, cube_t planes[]);
+
+#endif /* !__GRAY_H__ */
@@ -0,0 +1,274 @@
+#define _GNU_SOURCE      // For recvmmsg(2) and syscall(2) (fix warning on linux).
+#include <endian.h>      // le64toh(3) & co.
+#include <errno.h>       // errno(3).
+#include <linux/futex.h> // FUTEX_WAIT_PRIVATE, FUTEX_WAKE_PRIVATE.
+#include <netdb.h>       // getaddrinfo(3).
+#include <string.h>      // memset(3), memcpy(3), strncmp(3).
+#include <sys/socket.h>  // socket(2), bind(2), recvmmsg(2).
+#include <sys/syscall.h> // SYS_futex.
+#include <sys/un.h>      // struct sockaddr_un.
+#include <unistd.h>      // close(2), unlink(2), syscall(2).
+
+#include "ingest.h"
+#include "clock.h"       // clock_now_ns.
+
+// Receive timeout, so the thread notices when it has to stop.
+#define RECV_TIMEOUT_US 100000
+
+// Requested socket receive buffer, to absorb bursts while the ring is full.
+#define RECV_BUFFER     (1 << 20)
+
+// receive checks the received datagrams, converts them to host byte order and
+// packs the valid ones at the front of the batch. Returns the number of valid ones.
+static unsigned int     receive(ingest_t* ingest, struct mmsghdr* msgs, unsigned int count, uint64_t now) {
+  unsigned int          head  = ingest->head;
+  unsigned int          valid = 0;
+
+  for (unsigned int i = 0; i < count; i++) {
+    ingest_slot*        slot = &ingest->slots[(head + i) % INGEST_RING];
+    ingest_slot*        dst  = &ingest->slots[(head + valid) % INGEST_RING];
+
+    if (msgs[i].msg_len != sizeof(ingest_packet) || (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) ||
+        le32toh(slot->packet.unit) >= ingest->units) {
+      ingest->stats.invalid++;
+      continue;
+    }
+    slot->packet.seq    = le64toh(slot->packet.seq);
+    slot->packet.pts_ns = le64toh(slot->packet.pts_ns);
+    slot->packet.unit   = le32toh(slot->packet.unit);
+    if (dst != slot) {
+      memcpy(&dst->packet, &slot->packet, sizeof(dst->packet));
+    }
+    dst->arrival_ns = now;
+    valid++;
+  }
+  return valid;
+}
+
+// run is the receive thread, the single producer of the ring.
+// Datagrams land in the free slots, or get dropped in a scratch buffer when the ring is full.
+static void*            run(void* arg) {
+  ingest_t*             ingest = arg;
+  struct mmsghdr        msgs[INGEST_BATCH];
+  struct iovec          iovs[INGEST_BATCH];
+  ingest_packet         scratch;
+  unsigned int          head;
+  unsigned int          free;
+  unsigned int          count;
+  unsigned int          valid;
+  int                   ret;
+
+  while (ingest->running) {
+    head  = ingest->head;
+    free  = INGEST_RING - (head - __atomic_load_n(&ingest->tail, __ATOMIC_ACQUIRE));
+    count = free < INGEST_BATCH ? free : INGEST_BATCH;
+
+    memset(msgs, 0, sizeof(msgs));
+    for (unsigned int i = 0; i < (count ? count : INGEST_BATCH); i++) {
+      iovs[i].iov_base            = count ? (void*)&ingest->slots[(head + i) % INGEST_RING].packet : (void*)&scratch;
+      iovs[i].iov_len             = sizeof(ingest_packet);
+      msgs[i].msg_hdr.msg_iov     = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen  = 1;
+    }
+
+    // Block for the first datagram only, then take what is already queued.
+    if ((ret = recvmmsg(ingest->fd, msgs, count ? count : INGEST_BATCH, MSG_WAITFORONE, NULL)) <= 0) {
+      if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        break;
+      }
+      continue;
+    }
+    if (!count) {
+      ingest->stats.overrun += ret;
+      continue;
+    }
+
+    // Publish the valid frames, waking the consumer if it sleeps.
+    // Sequentially consistent with ingest_wait, so either it sees the new head or we see it waiting.
+    valid = receive(ingest, msgs, ret, clock_now_ns());
+    ingest->stats.received += valid;
+    ingest->stats.batches++;
+    __atomic_store_n(&ingest->head, head + valid, __ATOMIC_SEQ_CST);
+    if (valid && __atomic_load_n(&ingest->waiting, __ATOMIC_SEQ_CST)) {
+      syscall(SYS_futex, &ingest->head, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+  }
+
+  return NULL;
+}
+
+// ingest_address resolves "udp:[host:]port" or "unix:path".
+// Without host, passive addresses are the IPv4 wildcard, the others the IPv4 loopback.
+// Returns -1 with errno set on failure.
+int                     ingest_address(const char* address, int passive, struct sockaddr_storage* addr, socklen_t* len) {
+  struct addrinfo       hints = {
+    .ai_family   = AF_UNSPEC,
+    .ai_socktype = SOCK_DGRAM,
+    .ai_flags    = passive ? AI_PASSIVE : 0,
+  };
+  struct addrinfo*      res;
+  char                  host[256];
+  const char*           port;
+
+  memset(addr, 0, sizeof(*addr));
+
+  if (!strncmp(address, "unix:", 5)) {
+    struct sockaddr_un* un = (struct sockaddr_un*)addr;
+
+    if (strlen(address + 5) >= sizeof(un->sun_path)) {
+      errno = ENAMETOOLONG;
+      return -1;
+    }
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, address + 5);
+    *len = sizeof(*un);
+    return 0;
+  }
+
+  if (strncmp(address, "udp:", 4)) {
+    errno = EINVAL;
+    return -1;
+  }
+  address += 4;
+  if ((port = strrchr(address, ':'))) {
+    if ((size_t)(port - address) >= sizeof(host)) {
+      errno = ENAMETOOLONG;
+      return -1;
+    }
+    memcpy(host, address, port - address);
+    host[port++ - address] = 0;
+  } else {
+    // Without host, stick to IPv4 so the wildcard and the loopback match.
+    port            = address;
+    hints.ai_family = AF_INET;
+  }
+  if (getaddrinfo(port != address ? host : NULL, port, &hints, &res)) {
+    errno = EINVAL;
+    return -1;
+  }
+  memcpy(addr, res->ai_addr, res->ai_addrlen);
+  *len = res->ai_addrlen;
+  freeaddrinfo(res);
+  return 0;
+}
+
+// ingest_open binds the socket and starts the receive thread.
+// Returns -1 with errno set on failure.
+int                     ingest_open(ingest_t* ingest, const char* address, unsigned int units) {
+  struct sockaddr_storage addr;
+  socklen_t             len;
+  struct timeval        timeout = { .tv_sec = 0, .tv_usec = RECV_TIMEOUT_US };
+  int                   size    = RECV_BUFFER;
+  int                   ret;
+
+  memset(ingest, 0, sizeof(*ingest));
+  ingest->fd    = -1;
+  ingest->units = units;
+
+  if (ingest_address(address, 1, &addr, &len) < 0) {
+    return -1;
+  }
+  if ((ingest->fd = socket(addr.ss_family, SOCK_DGRAM, 0)) < 0) {
+    return -1;
+  }
+
+  // Replace a stale Unix socket.
+  if (addr.ss_family == AF_UNIX) {
+    strcpy(ingest->path, ((struct sockaddr_un*)&addr)->sun_path);
+    unlink(ingest->path);
+  }
+  if (bind(ingest->fd, (struct sockaddr*)&addr, len) < 0 ||
+      setsockopt(ingest->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+    ingest_close(ingest);
+    return -1;
+  }
+
+  // Best effort, capped by net.core.rmem_max.
+  setsockopt(ingest->fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+  ingest->running = 1;
+  if ((ret = pthread_create(&ingest->thread, NULL, run, ingest))) {
+    ingest->running = 0;
+    ingest_close(ingest);
+    errno = ret;
+    return -1;
+  }
+  return 0;
+}
+
+// ingest_close stops the receive thread and closes the socket.
+void    ingest_close(ingest_t* ingest) {
+  if (ingest->running) {
+    ingest->running = 0;
+    pthread_join(ingest->thread, NULL);
+  }
+  if (ingest->fd >= 0) {
+    close(ingest->fd);
+    ingest->fd = -1;
+  }
+  if (ingest->path[0]) {
+    unlink(ingest->path);
+    ingest->path[0] = 0;
+  }
+}
+
+// ingest_wait sleeps until a frame gets published while the ring is empty, or the timeout.
+// Returns 0 once published, -1 with errno set on timeout (ETIMEDOUT) or signal (EINTR).
+int                     ingest_wait(ingest_t* ingest, uint64_t timeout_ns) {
+  struct timespec       timeout = {
+    .tv_sec  = timeout_ns / NSEC_PER_SEC,
+    .tv_nsec = timeout_ns % NSEC_PER_SEC,
+  };
+  int                   ret     = 0;
+
+  __atomic_store_n(&ingest->waiting, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&ingest->head, __ATOMIC_SEQ_CST) == ingest->tail) {
+    ret = syscall(SYS_futex, &ingest->head, FUTEX_WAIT_PRIVATE, ingest->tail, &timeout, NULL, 0);
+  }
+  __atomic_store_n(&ingest->waiting, 0, __ATOMIC_SEQ_CST);
+
+  // Woken up, or the head moved before we slept.
+  if (ret < 0 && errno == EAGAIN) {
+    ret = 0;
+  }
+  return ret;
+}
+
+// ingest_account records a frame sent to the SPI, received latency ago.
+void    ingest_account(ingest_stats* stats, uint64_t latency) {
+  if (!stats->shown || latency < stats->min_ns) {
+    stats->min_ns = latency;
+  }
+  if (latency > stats->max_ns) {
+    stats->max_ns = latency;
+  }
+  stats->sum_ns += latency;
+  stats->shown++;
+}
+
+// ingest_merge adds the frames sent and their latencies recorded in other, e.g. by another thread, to stats.
+void    ingest_merge(ingest_stats* stats, const ingest_stats* other) {
+  if (!other->shown) {
+    return;
+  }
+  if (!stats->shown || other->min_ns < stats->min_ns) {
+    stats->min_ns = other->min_ns;
+  }
+  if (other->max_ns > stats->max_ns) {
+    stats->max_ns = other->max_ns;
+  }
+  stats->sum_ns += other->sum_ns;
+  stats->shown  += other->shown;
+}
+
+// ingest_report prints the frame counts and the arrival to SPI latency.
+void                    ingest_report(const ingest_t* ingest, FILE* out) {
+  const ingest_stats*   stats = &ingest->stats;
+
+  fprintf(out, "ingest: %llu frames received in %llu batches, %llu shown, %llu superseded, %llu late, %llu overrun, %llu invalid\n",
+          (unsigned long long)stats->received, (unsigned long long)stats->batches, (unsigned long long)stats->shown,
+          (unsigned long long)stats->superseded, (unsigned long long)stats->late, (unsigned long long)stats->overrun,
+          (unsigned long long)stats->invalid);
+  fprintf(out, "ingest: arrival to SPI latency min %.1f us, mean %.1f us, max %.1f us\n",
+          stats->min_ns / 1e3, stats->sum_ns / (stats->shown ? stats->shown : 1) / 1e3, stats->max_ns / 1e3);
+}
@@ -0,0 +1,113 @@
+#ifndef __INGEST_H__
+# define __INGEST_H__
+
+# include <pthread.h>    // pthread_t.
+# include <stdint.h>     // uint64_t & co.
+# include <stdio.h>      // FILE.
+# include <sys/socket.h> // struct sockaddr_storage, socklen_t.
+
+# include "cube.h"       // cube_t.
+
+/**
+   Frame ingest, to stream frames from other processes or machines.
+
+   Each datagram is an ingest_packet, a full frame for one of the cubes with its
+   sequence number and presentation time, sent over UDP ("udp:[host:]port") or a
+   Unix datagram socket ("unix:path"). A datagram is either received whole or not
+   at all, so a frame is always complete.
+
+   A receive thread pulls the datagrams in batches with recvmmsg(2), straight into
+   the free slots of a single-producer/single-consumer ring, and only publishes the
+   valid ones. The consumer peeks and pops them in order without any lock, and may
+   sleep on the ring head futex until frames get published.
+
+   Example:
+
+   ingest_t*     ingest = &static_ingest;
+
+   if (ingest_open(ingest, "udp:7595", cubes) < 0) { perror("ingest"); }
+   while ((slot = ingest_peek(ingest))) {
+     show(slot->packet.unit, slot->packet.frame);
+     ingest_pop(ingest);
+   }
+   ingest_close(ingest);
+*/
+
+// Number of slots of the ring, a power of 2.
+# define INGEST_RING        256
+
+// Maximum number of datagrams received per syscall.
+# define INGEST_BATCH       32
+
+// Frames due longer ago than that are dropped as late.
+# define INGEST_MAX_LATE_NS 50000000ULL
+
+// Wire format, little-endian.
+typedef struct {
+    uint64_t        seq;      // Sequence number, increasing for each cube from 1.
+    uint64_t        pts_ns;   // Presentation time on the receiver monotonic clock, 0 to show on arrival.
+    uint32_t        unit;     // Cube index, in the order of the devices.
+    uint32_t        reserved; // Zero.
+    cube_t          frame;    // Frame, in the cube_t memory layout.
+}                   ingest_packet;
+
+typedef struct {
+    ingest_packet   packet;     // In host byte order once published.
+    uint64_t        arrival_ns; // Monotonic time the batch was received.
+}                   ingest_slot;
+
+typedef struct {
+    // Receive thread.
+    uint64_t        received;   // Valid frames received.
+    uint64_t        invalid;    // Datagrams of the wrong size or for an unknown cube.
+    uint64_t        overrun;    // Frames dropped as the ring was full.
+    uint64_t        batches;    // Number of recvmmsg(2) returning frames.
+    // Consumer.
+    uint64_t        late;       // Frames dropped as late or out of order.
+    uint64_t        superseded; // Frames dropped as a newer one was due.
+    uint64_t        shown;      // Frames sent to the cubes.
+    uint64_t        min_ns;     // Minimum arrival (or presentation time if later) to SPI latency, once sent.
+    uint64_t        max_ns;     // Maximum arrival to SPI latency.
+    uint64_t        sum_ns;     // Sum of the arrival to SPI latencies.
+}                   ingest_stats;
+
+typedef struct {
+    int             fd;
+    unsigned int    units;     // Number of cubes, packets for other ones are invalid.
+    char            path[108]; // Unix socket path, removed on close.
+
+    // Private.
+    pthread_t       thread;
+    volatile int    running;
+
+    // Ring, each index on its own cache line.
+    unsigned int    head __attribute__((aligned(64))); // Written by the receive thread, futex word.
+    unsigned int    tail __attribute__((aligned(64))); // Written by the consumer.
+    unsigned int    waiting;                           // Set while the consumer sleeps on head.
+    ingest_slot     slots[INGEST_RING] __attribute__((aligned(64)));
+
+    ingest_stats    stats;
+}                   ingest_t;
+
+// ingest_peek returns the oldest frame of the ring, NULL if empty.
+static inline ingest_slot* ingest_peek(ingest_t* ingest) {
+  if (ingest->tail == __atomic_load_n(&ingest->head, __ATOMIC_ACQUIRE)) {
+    return NULL;
+  }
+  return &ingest->slots[ingest->tail % INGEST_RING];
+}
+
+// ingest_pop hands the oldest slot back to the receive thread.
+static inline void ingest_pop(ingest_t* ingest) {
+  __atomic_store_n(&ingest->tail, ingest->tail + 1, __ATOMIC_RELEASE);
+}
+
+int     ingest_address(const char* address, int passive, struct sockaddr_storage* addr, socklen_t* len);
+int     ingest_open(ingest_t* ingest, const char* address, unsigned int units);
+void    ingest_close(ingest_t* ingest);
+int     ingest_wait(ingest_t* ingest, uint64_t timeout_ns);
+void    ingest_account(ingest_stats* stats, uint64_t latency);
+void    ingest_merge(ingest_stats* stats, const ingest_stats* other);
+void    ingest_report(const ingest_t* ingest, FILE* out);
+
+#endif /* !__INGEST_H__ */
@@ -0,0 +1,235 @@
+#include <stdio.h>   // fprintf(3).
+#include <string.h>  // memset(3), memmove(3), memcmp(3).
+
+#include "kernels.h"
+
+// Bitboard masks.
+#define LAYER_X_LOW  0x0101010101010101ULL // X = 0 of each Z row.
+#define LAYER_Z_ROW  0xFFULL               // Z row CUBE_SIZE - 1, shift by (CUBE_SIZE - 1 - z) * CUBE_SIZE for z.
+
+// Scalar kernels, on 64 bits layer bitboards.
+
+static int      scalar_supported() {
+  return 1;
+}
+
+static void     scalar_clear(cube_t cube) {
+  memset(cube, 0, sizeof(cube_t));
+}
+
+// X and Z moves are word shifts of each layer, Y moves are layer moves.
+static void     scalar_shift(cube_t cube, shift_dir_t dir) {
+  switch (dir) {
+  case shiftPosX:
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      cube_put_layer(cube, y, (cube_get_layer(cube, y) << 1) & ~LAYER_X_LOW);
+    }
+    break;
+  case shiftNegX:
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      cube_put_layer(cube, y, (cube_get_layer(cube, y) >> 1) & ~(LAYER_X_LOW << (CUBE_SIZE - 1)));
+    }
+    break;
+
+  case shiftPosY:
+    memmove(cube[0], cube[1], sizeof(cube[0]) * (CUBE_SIZE - 1));
+    memset(cube[CUBE_SIZE - 1], 0, sizeof(cube[0]));
+    break;
+  case shiftNegY:
+    memmove(cube[1], cube[0], sizeof(cube[0]) * (CUBE_SIZE - 1));
+    memset(cube[0], 0, sizeof(cube[0]));
+    break;
+
+  case shiftPosZ:
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      cube_put_layer(cube, y, cube_get_layer(cube, y) >> CUBE_SIZE);
+    }
+    break;
+  case shiftNegZ:
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      cube_put_layer(cube, y, cube_get_layer(cube, y) << CUBE_SIZE);
+    }
+    break;
+  }
+}
+
+static void     scalar_set_plane(cube_t cube, axis_t axis, int n) {
+  switch (axis) {
+  case axisX:
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      cube_put_layer(cube, y, cube_get_layer(cube, y) | LAYER_X_LOW << n);
+    }
+    break;
+  case axisY:
+    cube_put_layer(cube, n, ~0ULL);
+    break;
+  case axisZ:
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      cube_put_layer(cube, y, cube_get_layer(cube, y) | LAYER_Z_ROW << (CUBE_SIZE - 1 - n) * CUBE_SIZE);
+    }
+    break;
+  }
+}
+
+static void             scalar_compose(cube_t dst, cube_t a, cube_t b, compose_op_t op) {
+  cube_layer_t          la;
+  cube_layer_t          lb;
+
+  for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+    la = cube_get_layer(a, y);
+    lb = cube_get_layer(b, y);
+    switch (op) {
+    case composeOr:
+      cube_put_layer(dst, y, la | lb);
+      break;
+    case composeAnd:
+      cube_put_layer(dst, y, la & lb);
+      break;
+    case composeXor:
+      cube_put_layer(dst, y, la ^ lb);
+      break;
+    case composeAndNot:
+      cube_put_layer(dst, y, la & ~lb);
+      break;
+    }
+  }
+}
+
+static unsigned int     scalar_popcount(cube_t cube) {
+  unsigned int          count = 0;
+
+  for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+    count += __builtin_popcountll(cube_get_layer(cube, y));
+  }
+  return count;
+}
+
+const cube_kernels_t    cube_kernels_scalar = {
+  .name      = "scalar",
+  .supported = scalar_supported,
+  .clear     = scalar_clear,
+  .shift     = scalar_shift,
+  .set_plane = scalar_set_plane,
+  .compose   = scalar_compose,
+  .popcount  = scalar_popcount,
+  .remap     = remap_apply_scalar,
+};
+
+// Selection.
+
+const cube_kernels_t*   cube_kernels_all[] = {
+#if defined(__x86_64__) || defined(__i386__)
+  &cube_kernels_avx2,
+  &cube_kernels_sse2,
+#endif
+#if defined(__aarch64__) || defined(__arm__)
+  &cube_kernels_neon,
+#endif
+  &cube_kernels_scalar,
+  NULL,
+};
+
+const cube_kernels_t*   cube_kernels = &cube_kernels_scalar;
+
+// cube_kernels_init selects the best supported kernels matching the scalar ones.
+const cube_kernels_t*   cube_kernels_init(const remap_t* remap) {
+  for (const cube_kernels_t** k = cube_kernels_all; *k; k++) {
+    if (!(*k)->supported()) {
+      continue;
+    }
+    if (cube_kernels_verify(*k, remap) < 0) {
+      fprintf(stderr, "kernels: %s mismatch, skipped\n", (*k)->name);
+      continue;
+    }
+    cube_kernels = *k;
+    break;
+  }
+  return cube_kernels;
+}
+
+// Verification.
+
+// next_random is a small xorshift generator, so verification is reproducible.
+static uint64_t next_random(uint64_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// random_cube fills the cube with random voxels.
+static void     random_cube(cube_t cube, uint64_t* state) {
+  for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+    cube_put_layer(cube, y, next_random(state));
+  }
+}
+
+// cube_kernels_verify checks each kernel against the scalar one on random cubes.
+// remap may be NULL to skip the remap kernel. Returns -1 on mismatch.
+int                     cube_kernels_verify(const cube_kernels_t* kernels, const remap_t* remap) {
+  const cube_kernels_t* ref   = &cube_kernels_scalar;
+  uint64_t              state = 0x9E3779B97F4A7C15ULL;
+  cube_t                a;
+  cube_t                b;
+  cube_t                got;
+  cube_t                want;
+
+  for (unsigned int i = 0; i < 64; i++) {
+    random_cube(a, &state);
+    random_cube(b, &state);
+
+    // Clear.
+    memcpy(got, a, sizeof(cube_t));
+    kernels->clear(got);
+    ref->clear(want);
+    if (memcmp(got, want, sizeof(cube_t))) {
+      return -1;
+    }
+
+    // Shift.
+    for (shift_dir_t dir = shiftPosX; dir <= shiftNegZ; dir++) {
+      memcpy(got, a, sizeof(cube_t));
+      memcpy(want, a, sizeof(cube_t));
+      kernels->shift(got, dir);
+      ref->shift(want, dir);
+      if (memcmp(got, want, sizeof(cube_t))) {
+        return -1;
+      }
+    }
+
+    // Plane.
+    for (axis_t axis = axisX; axis <= axisZ; axis++) {
+      memcpy(got, a, sizeof(cube_t));
+      memcpy(want, a, sizeof(cube_t));
+      kernels->set_plane(got, axis, i % CUBE_SIZE);
+      ref->set_plane(want, axis, i % CUBE_SIZE);
+      if (memcmp(got, want, sizeof(cube_t))) {
+        return -1;
+      }
+    }
+
+    // Compose.
+    for (compose_op_t op = composeOr; op <= composeAndNot; op++) {
+      kernels->compose(got, a, b, op);
+      ref->compose(want, a, b, op);
+      if (memcmp(got, want, sizeof(cube_t))) {
+        return -1;
+      }
+    }
+
+    // Popcount.
+    if (kernels->popcount(a) != ref->popcount(a)) {
+      return -1;
+    }
+
+    // Remap.
+    if (remap) {
+      kernels->remap(remap, a, got);
+      ref->remap(remap, a, want);
+      if (memcmp(got, want, sizeof(cube_t))) {
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
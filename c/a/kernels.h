@@ -0,0 +1,40 @@
+#ifndef __KERNELS_H__
+# define __KERNELS_H__
+
+# include "cube.h"  // cube_t & co.
+# include "remap.h" // remap_t.
+
+/**
+   Whole cube kernels, behind the cube.h API and remap_apply.
+
+   The 64 bytes cube fits in four SSE2/NEON or two AVX2 registers. Each
+   implementation is selected at runtime from the CPU features, and checked
+   against the scalar one before use.
+*/
+
+typedef struct {
+    const char*     name;
+    int             (*supported)();
+    void            (*clear)(cube_t cube);
+    void            (*shift)(cube_t cube, shift_dir_t dir);
+    void            (*set_plane)(cube_t cube, axis_t axis, int n);
+    void            (*compose)(cube_t dst, cube_t a, cube_t b, compose_op_t op);
+    unsigned int    (*popcount)(cube_t cube);
+    void            (*remap)(const remap_t* remap, cube_t src, cube_t dst);
+}                   cube_kernels_t;
+
+extern const cube_kernels_t     cube_kernels_scalar;
+extern const cube_kernels_t     cube_kernels_sse2;
+extern const cube_kernels_t     cube_kernels_avx2;
+extern const cube_kernels_t     cube_kernels_neon;
+
+// Kernels compiled in, best first, NULL terminated.
+extern const cube_kernels_t*    cube_kernels_all[];
+
+// Selected kernels, scalar until cube_kernels_init.
+extern const cube_kernels_t*    cube_kernels;
+
+const cube_kernels_t*   cube_kernels_init(const remap_t* remap);
+int                     cube_kernels_verify(const cube_kernels_t* kernels, const remap_t* remap);
+
+#endif /* !__KERNELS_H__ */
@@ -0,0 +1,183 @@
+#include "kernels.h"
+
+#if (defined(__aarch64__) || defined(__arm__)) && defined(__ARM_NEON)
+
+# include <arm_neon.h>     // NEON intrinsics.
+# ifndef __aarch64__
+#  include <sys/auxv.h>    // getauxval(3).
+#  include <asm/hwcap.h>   // HWCAP_NEON.
+# endif
+
+/**
+   NEON kernels: the cube as four 16 bytes registers, two Y layers each.
+   The Raspberry Pi 2 and later have NEON, the first ones don't.
+*/
+
+static inline void      neon_load(uint8x16_t v[4], cube_t cube) {
+  for (unsigned int r = 0; r < 4; r++) {
+    v[r] = vld1q_u8(&cube[2 * r][0]);
+  }
+}
+
+static inline void      neon_store(cube_t cube, uint8x16_t v[4]) {
+  for (unsigned int r = 0; r < 4; r++) {
+    vst1q_u8(&cube[2 * r][0], v[r]);
+  }
+}
+
+static int      neon_supported() {
+# ifdef __aarch64__
+  return 1;
+# else
+  return !!(getauxval(AT_HWCAP) & HWCAP_NEON);
+# endif
+}
+
+static void     neon_clear(cube_t cube) {
+  uint8x16_t    v[4];
+
+  for (unsigned int r = 0; r < 4; r++) {
+    v[r] = vdupq_n_u8(0);
+  }
+  neon_store(cube, v);
+}
+
+// X moves are byte shifts, Z moves 64 bits word shifts and Y moves 8 bytes extractions across registers.
+static void     neon_shift(cube_t cube, shift_dir_t dir) {
+  uint8x16_t    v[4];
+  uint8x16_t    out[4];
+  uint8x16_t    zero = vdupq_n_u8(0);
+
+  neon_load(v, cube);
+  for (unsigned int r = 0; r < 4; r++) {
+    switch (dir) {
+    case shiftPosX:
+      out[r] = vshlq_n_u8(v[r], 1);
+      break;
+    case shiftNegX:
+      out[r] = vshrq_n_u8(v[r], 1);
+      break;
+    case shiftPosY:
+      out[r] = vextq_u8(v[r], r < 3 ? v[r + 1] : zero, 8);
+      break;
+    case shiftNegY:
+      out[r] = vextq_u8(r > 0 ? v[r - 1] : zero, v[r], 8);
+      break;
+    case shiftPosZ:
+      out[r] = vreinterpretq_u8_u64(vshrq_n_u64(vreinterpretq_u64_u8(v[r]), CUBE_SIZE));
+      break;
+    case shiftNegZ:
+      out[r] = vreinterpretq_u8_u64(vshlq_n_u64(vreinterpretq_u64_u8(v[r]), CUBE_SIZE));
+      break;
+    }
+  }
+  neon_store(cube, out);
+}
+
+static void     neon_set_plane(cube_t cube, axis_t axis, int n) {
+  uint8x16_t    v[4];
+  uint8x16_t    mask;
+
+  if (axis == axisY) {
+    memset(cube[CUBE_SIZE - 1 - n], 0xFF, sizeof(cube[0]));
+    return;
+  }
+  if (axis == axisX) {
+    mask = vdupq_n_u8(0x01 << n);
+  } else {
+    mask = vreinterpretq_u8_u64(vdupq_n_u64(0xFFULL << (CUBE_SIZE - 1 - n) * CUBE_SIZE));
+  }
+  neon_load(v, cube);
+  for (unsigned int r = 0; r < 4; r++) {
+    v[r] = vorrq_u8(v[r], mask);
+  }
+  neon_store(cube, v);
+}
+
+static void     neon_compose(cube_t dst, cube_t a, cube_t b, compose_op_t op) {
+  uint8x16_t    va[4];
+  uint8x16_t    vb[4];
+
+  neon_load(va, a);
+  neon_load(vb, b);
+  for (unsigned int r = 0; r < 4; r++) {
+    switch (op) {
+    case composeOr:
+      va[r] = vorrq_u8(va[r], vb[r]);
+      break;
+    case composeAnd:
+      va[r] = vandq_u8(va[r], vb[r]);
+      break;
+    case composeXor:
+      va[r] = veorq_u8(va[r], vb[r]);
+      break;
+    case composeAndNot:
+      va[r] = vbicq_u8(va[r], vb[r]);
+      break;
+    }
+  }
+  neon_store(dst, va);
+}
+
+// Byte popcount, then pairwise widening sums.
+static unsigned int     neon_popcount(cube_t cube) {
+  uint8x16_t            v[4];
+  uint64x2_t            sum = vdupq_n_u64(0);
+
+  neon_load(v, cube);
+  for (unsigned int r = 0; r < 4; r++) {
+    sum = vaddq_u64(sum, vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vcntq_u8(v[r])))));
+  }
+  return vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1);
+}
+
+# ifdef __aarch64__
+// Each output register gathers its bytes from the four source registers,
+// then the reversed X rows get their bits reversed.
+static void     neon_remap(const remap_t* remap, cube_t src, cube_t dst) {
+  uint8x16_t    v[4];
+  uint8x16_t    out[4];
+
+  if (!remap->simd) {
+    remap_apply_scalar(remap, src, dst);
+    return;
+  }
+
+  neon_load(v, src);
+  for (unsigned int k = 0; k < 4; k++) {
+    out[k] = vdupq_n_u8(0);
+    for (unsigned int j = 0; j < 4; j++) {
+      out[k] = vorrq_u8(out[k], vqtbl1q_u8(v[j], vld1q_u8(remap->shuffle[j][k])));
+    }
+    out[k] = vbslq_u8(vld1q_u8(&remap->reverse[16 * k]), vrbitq_u8(out[k]), out[k]);
+  }
+  neon_store(dst, out);
+}
+# else
+#  define neon_remap remap_apply_scalar // No full register table lookup on ARMv7.
+# endif
+
+const cube_kernels_t    cube_kernels_neon = {
+  .name      = "neon",
+  .supported = neon_supported,
+  .clear     = neon_clear,
+  .shift     = neon_shift,
+  .set_plane = neon_set_plane,
+  .compose   = neon_compose,
+  .popcount  = neon_popcount,
+  .remap     = neon_remap,
+};
+
+#elif defined(__aarch64__) || defined(__arm__)
+
+// Compiled without NEON, as on ARMv6 where the Makefile doesn't enable it: never selected.
+static int      neon_supported() {
+  return 0;
+}
+
+const cube_kernels_t    cube_kernels_neon = {
+  .name      = "neon",
+  .supported = neon_supported,
+};
+
+#endif /* !__ARM_NEON */
@@ -0,0 +1,323 @@
+#include "kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+# include <immintrin.h> // SSE2/AVX2 intrinsics.
+
+/**
+   SSE2 kernels: the cube as four 16 bytes registers, two Y layers each.
+*/
+
+# define SSE2 __attribute__((target("sse2")))
+
+SSE2 static inline void sse2_load(__m128i v[4], cube_t cube) {
+  for (unsigned int r = 0; r < 4; r++) {
+    v[r] = _mm_loadu_si128((const __m128i*)&cube[2 * r][0]);
+  }
+}
+
+SSE2 static inline void sse2_store(cube_t cube, __m128i v[4]) {
+  for (unsigned int r = 0; r < 4; r++) {
+    _mm_storeu_si128((__m128i*)&cube[2 * r][0], v[r]);
+  }
+}
+
+static int      sse2_supported() {
+  return __builtin_cpu_supports("sse2");
+}
+
+SSE2 static void        sse2_clear(cube_t cube) {
+  __m128i               v[4];
+
+  for (unsigned int r = 0; r < 4; r++) {
+    v[r] = _mm_setzero_si128();
+  }
+  sse2_store(cube, v);
+}
+
+// X moves are byte shifts, Z moves 64 bits word shifts and Y moves 8 bytes register shifts.
+SSE2 static void        sse2_shift(cube_t cube, shift_dir_t dir) {
+  __m128i               v[4];
+  __m128i               out[4];
+
+  sse2_load(v, cube);
+  for (unsigned int r = 0; r < 4; r++) {
+    switch (dir) {
+    case shiftPosX:
+      out[r] = _mm_add_epi8(v[r], v[r]);
+      break;
+    case shiftNegX:
+      out[r] = _mm_and_si128(_mm_srli_epi16(v[r], 1), _mm_set1_epi8(0x7F));
+      break;
+    case shiftPosY:
+      out[r] = _mm_srli_si128(v[r], 8);
+      if (r < 3) {
+        out[r] = _mm_or_si128(out[r], _mm_slli_si128(v[r + 1], 8));
+      }
+      break;
+    case shiftNegY:
+      out[r] = _mm_slli_si128(v[r], 8);
+      if (r > 0) {
+        out[r] = _mm_or_si128(out[r], _mm_srli_si128(v[r - 1], 8));
+      }
+      break;
+    case shiftPosZ:
+      out[r] = _mm_srli_epi64(v[r], CUBE_SIZE);
+      break;
+    case shiftNegZ:
+      out[r] = _mm_slli_epi64(v[r], CUBE_SIZE);
+      break;
+    }
+  }
+  sse2_store(cube, out);
+}
+
+SSE2 static void        sse2_set_plane(cube_t cube, axis_t axis, int n) {
+  __m128i               v[4];
+  __m128i               mask;
+
+  if (axis == axisY) {
+    memset(cube[CUBE_SIZE - 1 - n], 0xFF, sizeof(cube[0]));
+    return;
+  }
+  if (axis == axisX) {
+    mask = _mm_set1_epi8(0x01 << n);
+  } else {
+    mask = _mm_set1_epi64x(0xFFLL << (CUBE_SIZE - 1 - n) * CUBE_SIZE);
+  }
+  sse2_load(v, cube);
+  for (unsigned int r = 0; r < 4; r++) {
+    v[r] = _mm_or_si128(v[r], mask);
+  }
+  sse2_store(cube, v);
+}
+
+SSE2 static void        sse2_compose(cube_t dst, cube_t a, cube_t b, compose_op_t op) {
+  __m128i               va[4];
+  __m128i               vb[4];
+
+  sse2_load(va, a);
+  sse2_load(vb, b);
+  for (unsigned int r = 0; r < 4; r++) {
+    switch (op) {
+    case composeOr:
+      va[r] = _mm_or_si128(va[r], vb[r]);
+      break;
+    case composeAnd:
+      va[r] = _mm_and_si128(va[r], vb[r]);
+      break;
+    case composeXor:
+      va[r] = _mm_xor_si128(va[r], vb[r]);
+      break;
+    case composeAndNot:
+      va[r] = _mm_andnot_si128(vb[r], va[r]);
+      break;
+    }
+  }
+  sse2_store(dst, va);
+}
+
+// SWAR byte popcount, then summed by psadbw.
+SSE2 static unsigned int        sse2_popcount(cube_t cube) {
+  __m128i                       v[4];
+  __m128i                       sum = _mm_setzero_si128();
+  __m128i                       x;
+
+  sse2_load(v, cube);
+  for (unsigned int r = 0; r < 4; r++) {
+    x   = _mm_sub_epi8(v[r], _mm_and_si128(_mm_srli_epi16(v[r], 1), _mm_set1_epi8(0x55)));
+    x   = _mm_add_epi8(_mm_and_si128(x, _mm_set1_epi8(0x33)), _mm_and_si128(_mm_srli_epi16(x, 2), _mm_set1_epi8(0x33)));
+    x   = _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi16(x, 4)), _mm_set1_epi8(0x0F));
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(x, _mm_setzero_si128()));
+  }
+  return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+}
+
+const cube_kernels_t    cube_kernels_sse2 = {
+  .name      = "sse2",
+  .supported = sse2_supported,
+  .clear     = sse2_clear,
+  .shift     = sse2_shift,
+  .set_plane = sse2_set_plane,
+  .compose   = sse2_compose,
+  .popcount  = sse2_popcount,
+  .remap     = remap_apply_scalar, // No byte shuffle before SSSE3.
+};
+
+/**
+   AVX2 kernels: the cube as two 32 bytes registers, four Y layers each.
+*/
+
+# define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline void avx2_load(__m256i v[2], cube_t cube) {
+  v[0] = _mm256_loadu_si256((const __m256i*)&cube[0][0]);
+  v[1] = _mm256_loadu_si256((const __m256i*)&cube[4][0]);
+}
+
+AVX2 static inline void avx2_store(cube_t cube, __m256i v[2]) {
+  _mm256_storeu_si256((__m256i*)&cube[0][0], v[0]);
+  _mm256_storeu_si256((__m256i*)&cube[4][0], v[1]);
+}
+
+static int      avx2_supported() {
+  return __builtin_cpu_supports("avx2");
+}
+
+AVX2 static void        avx2_clear(cube_t cube) {
+  __m256i               v[2] = { _mm256_setzero_si256(), _mm256_setzero_si256() };
+
+  avx2_store(cube, v);
+}
+
+// Y moves rotate the 64 bits words of each register and blend in the one crossing registers.
+AVX2 static void        avx2_shift(cube_t cube, shift_dir_t dir) {
+  __m256i               v[2];
+  __m256i               out[2];
+  __m256i               zero = _mm256_setzero_si256();
+
+  avx2_load(v, cube);
+  switch (dir) {
+  case shiftPosY:
+    v[0]   = _mm256_permute4x64_epi64(v[0], _MM_SHUFFLE(0, 3, 2, 1));
+    v[1]   = _mm256_permute4x64_epi64(v[1], _MM_SHUFFLE(0, 3, 2, 1));
+    out[0] = _mm256_blend_epi32(v[0], v[1], 0xC0);
+    out[1] = _mm256_blend_epi32(v[1], zero, 0xC0);
+    break;
+  case shiftNegY:
+    v[0]   = _mm256_permute4x64_epi64(v[0], _MM_SHUFFLE(2, 1, 0, 3));
+    v[1]   = _mm256_permute4x64_epi64(v[1], _MM_SHUFFLE(2, 1, 0, 3));
+    out[0] = _mm256_blend_epi32(v[0], zero, 0x03);
+    out[1] = _mm256_blend_epi32(v[1], v[0], 0x03);
+    break;
+  default:
+    for (unsigned int r = 0; r < 2; r++) {
+      switch (dir) {
+      case shiftPosX:
+        out[r] = _mm256_add_epi8(v[r], v[r]);
+        break;
+      case shiftNegX:
+        out[r] = _mm256_and_si256(_mm256_srli_epi16(v[r], 1), _mm256_set1_epi8(0x7F));
+        break;
+      case shiftPosZ:
+        out[r] = _mm256_srli_epi64(v[r], CUBE_SIZE);
+        break;
+      default:
+        out[r] = _mm256_slli_epi64(v[r], CUBE_SIZE);
+        break;
+      }
+    }
+    break;
+  }
+  avx2_store(cube, out);
+}
+
+AVX2 static void        avx2_set_plane(cube_t cube, axis_t axis, int n) {
+  __m256i               v[2];
+  __m256i               mask;
+
+  if (axis == axisY) {
+    memset(cube[CUBE_SIZE - 1 - n], 0xFF, sizeof(cube[0]));
+    return;
+  }
+  if (axis == axisX) {
+    mask = _mm256_set1_epi8(0x01 << n);
+  } else {
+    mask = _mm256_set1_epi64x(0xFFLL << (CUBE_SIZE - 1 - n) * CUBE_SIZE);
+  }
+  avx2_load(v, cube);
+  v[0] = _mm256_or_si256(v[0], mask);
+  v[1] = _mm256_or_si256(v[1], mask);
+  avx2_store(cube, v);
+}
+
+AVX2 static void        avx2_compose(cube_t dst, cube_t a, cube_t b, compose_op_t op) {
+  __m256i               va[2];
+  __m256i               vb[2];
+
+  avx2_load(va, a);
+  avx2_load(vb, b);
+  for (unsigned int r = 0; r < 2; r++) {
+    switch (op) {
+    case composeOr:
+      va[r] = _mm256_or_si256(va[r], vb[r]);
+      break;
+    case composeAnd:
+      va[r] = _mm256_and_si256(va[r], vb[r]);
+      break;
+    case composeXor:
+      va[r] = _mm256_xor_si256(va[r], vb[r]);
+      break;
+    case composeAndNot:
+      va[r] = _mm256_andnot_si256(vb[r], va[r]);
+      break;
+    }
+  }
+  avx2_store(dst, va);
+}
+
+// Nibble popcount LUT, per 16 bytes lane.
+AVX2 static inline __m256i      avx2_nibble_lut(char b0, char b1, char b2, char b3, char b4, char b5, char b6, char b7,
+                                                char b8, char b9, char ba, char bb, char bc, char bd, char be, char bf) {
+  return _mm256_setr_epi8(b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, ba, bb, bc, bd, be, bf,
+                          b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, ba, bb, bc, bd, be, bf);
+}
+
+AVX2 static unsigned int        avx2_popcount(cube_t cube) {
+  __m256i                       v[2];
+  __m256i                       lut  = avx2_nibble_lut(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  __m256i                       low  = _mm256_set1_epi8(0x0F);
+  __m256i                       sum  = _mm256_setzero_si256();
+  __m256i                       x;
+  __m128i                       half;
+
+  avx2_load(v, cube);
+  for (unsigned int r = 0; r < 2; r++) {
+    x   = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v[r], low)),
+                          _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v[r], 4), low)));
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(x, _mm256_setzero_si256()));
+  }
+  half = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  return _mm_cvtsi128_si32(half) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(half, half));
+}
+
+// Each source lane is broadcast and shuffled to both halves of an output register pair,
+// then the reversed X rows get their bits reversed through a nibble LUT.
+AVX2 static void        avx2_remap(const remap_t* remap, cube_t src, cube_t dst) {
+  __m256i               out[2] = { _mm256_setzero_si256(), _mm256_setzero_si256() };
+  __m256i               lut    = avx2_nibble_lut(0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF);
+  __m256i               low    = _mm256_set1_epi8(0x0F);
+  __m256i               lane;
+  __m256i               rev;
+
+  if (!remap->simd) {
+    remap_apply_scalar(remap, src, dst);
+    return;
+  }
+
+  for (unsigned int j = 0; j < 4; j++) {
+    lane = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)&src[0][0] + j));
+    for (unsigned int r = 0; r < 2; r++) {
+      out[r] = _mm256_or_si256(out[r], _mm256_shuffle_epi8(lane, _mm256_loadu_si256((const __m256i*)remap->shuffle[j][2 * r])));
+    }
+  }
+  for (unsigned int r = 0; r < 2; r++) {
+    rev    = _mm256_or_si256(_mm256_slli_epi16(_mm256_shuffle_epi8(lut, _mm256_and_si256(out[r], low)), 4),
+                             _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(out[r], 4), low)));
+    out[r] = _mm256_blendv_epi8(out[r], rev, _mm256_loadu_si256((const __m256i*)&remap->reverse[32 * r]));
+  }
+  avx2_store(dst, out);
+}
+
+const cube_kernels_t    cube_kernels_avx2 = {
+  .name      = "avx2",
+  .supported = avx2_supported,
+  .clear     = avx2_clear,
+  .shift     = avx2_shift,
+  .set_plane = avx2_set_plane,
+  .compose   = avx2_compose,
+  .popcount  = avx2_popcount,
+  .remap     = avx2_remap,
+};
+
+#endif /* !__x86_64__ && !__i386__ */
@@ -1,34 +1,100 @@
 #define _DEFAULT_SOURCE // For usleep(3) (fix warning on linux).
 #include <unistd.h>     // usleep(3).
-#include <time.h>       // time(2) (for random seed).
+#include <time.h>       // time(2) (for random seeds).
 #include <stdio.h>      // perror(3), printf(3) & co.
-#include <stdlib.h>     // srand(3).
+#include <string.h>     // memcpy(3), strerror(3).
 
 #include "spi.h"        // SPI lib.
 #include "cube.h"       // Cube managment.
 #include "scenes.h"     // Scenes.
+#include "options.h"    // options_t.
+#include "remap.h"      // Hardware mapping.
+#include "tribuf.h"     // Frames hand over.
+#include "refresh.h"    // Refresh thread.
+#include "gray.h"       // Grayscale cube.
+#include "clock.h"      // Monotonic clock.
+#include "kernels.h"    // Cube kernels.
+#include "anim.h"       // Baked animations.
+#include "ingest.h"     // Frame ingest.
+#include "shmfb.h"      // Shared memory framebuffer.
+#include "stats.h"      // Latency histograms.
 
-// Cube state.
-cube_t cube;
-
-// Scene handler.
-void (*scene)(cube_t);
-
-// SPI handler config.
-spi_handler hdlr = {
-  .config =  {
-    .device = "/dev/spidev0.0", // Device to use.
-    .mode   = 0,                // Mode 0 with LSB first.
-    .bits   = 8,                // 8 bits per words.
-    .speed  = 8000000,          // 8MHz
-    .delay  = 5,                // 5 micro secs in between iterations.
-  },
+// SPI config of each cube, the device aside.
+static const spi_config config = {
+  .device = "/dev/spidev0.0", // Device to use.
+  .mode   = 0,                // Mode 0 with LSB first.
+  .bits   = 8,                // 8 bits per words.
+  .speed  = 8000000,          // 8MHz
+  .delay  = 5,                // 5 micro secs in between iterations.
 };
 
-// get_voxel checks if a point is on or fof in the cube.
-static inline int get_voxel(cube_t cube, int x, int y, int z) {
-  return (cube[CUBE_SIZE - 1 - y][CUBE_SIZE - 1 - z] & (0x01 << x)) == (0x01 << x) ? 1 : 0;
-}
+// unit_t is a cube on its own SPI device, running its own scene instance.
+typedef struct {
+  spi_handler   hdlr;
+  cube_t        cube;
+  scene_t       scene;
+  uint64_t      next_step;                    // Monotonic time (nsec) of the next scene step.
+  uint32_t      anim_step;                    // Next step of the baked animation.
+  cube_size_t   (*shown)[CUBE_SIZE];          // Last baked frame shown.
+  uint64_t      ingest_seq;                   // Sequence number of the last streamed frame taken.
+  shmfb_reader  shared;                       // Frames published in the shared framebuffer.
+  uint64_t      ingest_arrival;               // Arrival time, or presentation time if later, of the streamed frame not sent yet, 0 if none.
+  tribuf_t      frames;                       // Frames published to the refresh thread.
+  uint64_t      frame_arrival[3];             // Arrival time of the streamed frame in each slot of frames, 0 once sent.
+  refresh_t*    refresh;                      // Refresh thread of the bus, when enabled.
+  cube_size_t   tx[CUBE_SIZE + 1][CUBE_SIZE + 1]; // Frame buffer sent to the SPI, one word per cathode layer, then a blank word.
+  uint16_t      tx_holds[CUBE_SIZE + 1];      // Hold time of each word of the frame buffer, none for the blank word.
+  gray_t        gray;                         // Grayscale cube, when enabled.
+  cube_size_t   gray_tx[CUBE_SIZE * GRAY_MAX_BITS + 1][CUBE_SIZE + 1]; // Grayscale frame buffer, one word per bit-plane per layer.
+  stats_hist*   pack_stats;                   // Remap and pack time, NULL when disabled.
+  stats_hist*   spi_stats;                    // SPI transfer time of each message.
+} unit_t;
+
+// bus_t is the cubes sharing a SPI bus, /dev/spidevN.* for bus N.
+// Only one transfer at the time goes on a bus, so a single thread refreshes them all.
+typedef struct {
+  int           id;
+  unit_t*       units[OPTIONS_MAX_DEVICES];
+  unsigned int  count;
+  refresh_t     refresh;
+  stats_hist*   interval_stats;               // Time in between the frames sent, NULL when disabled.
+  uint64_t      last_send;                    // Start of the last frame sent.
+  ingest_stats  ingest_stats;                 // Streamed frames sent by the refresh thread, merged on cleanup.
+} bus_t;
+
+// Cubes and buses.
+static unit_t           units[OPTIONS_MAX_DEVICES];
+static unsigned int     unit_count;
+static bus_t            buses[OPTIONS_MAX_DEVICES];
+static unsigned int     bus_count;
+
+// Scene handler, each cube runs its own instance.
+static long (*scene)(scene_t*, cube_t);
+
+// Grayscale scene handler, when enabled.
+static long (*gray_scene)(scene_t*, gray_t);
+
+// Baked animation played instead of the scene, when enabled.
+static anim_t anim;
+
+// Frames streamed from other processes, when enabled.
+static ingest_t ingest;
+static int      ingesting;
+
+// Shared memory framebuffer written by other processes, when enabled.
+static shmfb_t  shmfb;
+static int      sharing;
+
+// Latency histograms, when enabled. Each has a single writer: the main loop or the refresh thread of the bus.
+static stats_t          stats;
+static stats_hist*      step_stats; // Scene step time.
+
+// How long the main loop sleeps when the refresh threads read the shared framebuffer (nsec).
+#define SHARED_IDLE_NS 100000000
+
+// How long the main loop waits at most for streamed frames when the refresh threads render (nsec),
+// so it notices the refresh errors and the stop.
+#define INGEST_IDLE_NS 100000000
 
 // Hardware mapping.
 
@@ -39,107 +105,616 @@ static const int y_map[CUBE_SIZE][CUBE_SIZE] = {{0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,
 // Z wiring on X axis.
 static const int z_map[CUBE_SIZE][CUBE_SIZE] = {{1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}, {1,0,3,2,5,4,7,6}};
 
-static void map_cube(cube_t src, cube_t dst) {
-  // Make sure the dst is cleared.
-  clear_cube(dst);
-
-  // For each point of the cube, map x/y/z to match the defined hardware wiring.
-  for (unsigned int x = 0; x < CUBE_SIZE; x++) {
-    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
-      for (unsigned int z = 0; z < CUBE_SIZE; z++) {
-	if (get_voxel(src, x, y, z)) {
-	  int xx = x_map[z][x];
-	  int yy = y_map[x][y];
-	  int zz = z_map[x][z];
-	  set_voxel(dst, xx, yy, zz);
-	}
+// Delay in between main loop iterations (usec).
+static unsigned int loop_delay;
+
+// Refresh threads running.
+static int refreshing;
+
+// Compiled hardware mapping.
+static remap_t remap;
+
+// Grayscale bits and hold time of each grayscale word.
+// The last word blanks the cube so the time until the next frame doesn't add to the last bit-plane.
+static int              gray_bits;
+static uint16_t         gray_holds[CUBE_SIZE * GRAY_MAX_BITS + 1];
+
+// pack_cube maps the cube to the hardware and packs it in the frame buffer of the unit.
+static void     pack_cube(unit_t* unit, cube_t cube) {
+  uint64_t      start = stats_start(unit->pack_stats);
+  cube_t        mapped_cube;
+
+  // Map the memory cube to the hardware.
+  remap_apply(&remap, cube, mapped_cube);
+
+  // Pack one word per cathode layer.
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    pack_layer(unit->tx[i], mapped_cube, i);
+  }
+  stats_stop(unit->pack_stats, start);
+}
+
+// send_unit sends words of the packed frame buffer of the unit, timing the message.
+// holds may be NULL to hold each word for the configured delay.
+static inline int       send_unit(unit_t* unit, const void* tx, int len, int count, const uint16_t* holds) {
+  uint64_t              start = stats_start(unit->spi_stats);
+  int                   ret;
+
+  ret = spi_transfer_frame_hold(&unit->hdlr, tx, len, count, holds);
+  stats_stop(unit->spi_stats, start);
+  return ret;
+}
+
+// send_bus uses SPI to display the packed frame buffers of the cubes of the bus.
+// A single cube gets its whole frame at once, latching one cathode at the time.
+// Several cubes get their layers interleaved, so each layer stays on for the same time.
+// Each frame ends with the blank word, so the last layer doesn't stay on until the next frame.
+static int      send_bus(bus_t* bus) {
+  uint64_t      now = stats_start(bus->interval_stats);
+  int           ret;
+
+  if (bus->interval_stats) {
+    if (bus->last_send) {
+      stats_record(bus->interval_stats, now - bus->last_send);
+    }
+    bus->last_send = now;
+  }
+
+  if (bus->count == 1) {
+    return send_unit(bus->units[0], bus->units[0]->tx, sizeof(bus->units[0]->tx[0]), CUBE_SIZE + 1, bus->units[0]->tx_holds);
+  }
+
+  for (unsigned int i = 0; i < CUBE_SIZE + 1; i++) {
+    for (unsigned int u = 0; u < bus->count; u++) {
+      if ((ret = send_unit(bus->units[u], bus->units[u]->tx[i], sizeof(bus->units[u]->tx[i]), 1, NULL)) < 0) {
+        return ret;
       }
     }
   }
+
+  return 0;
 }
 
-// render_cube uses SPI to display the cube.
-int             render_cube(const spi_handler hdlr, cube_t cube) {
+// setup_gray computes the hold time of each grayscale word.
+// Bit-plane b has to be displayed for 2^b units, a unit being the wire time of a word as the
+// next word is shifted while the current one is displayed.
+static void     setup_gray(int bits) {
+  unsigned int  wire_us = ((CUBE_SIZE + 1) * config.bits * 1000000 + config.speed - 1) / config.speed;
+
+  gray_bits = bits;
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    for (int b = 0; b < bits; b++) {
+      gray_holds[i * bits + b] = (wire_us << b) - wire_us;
+    }
+  }
+
+  // Blank word.
+  gray_holds[CUBE_SIZE * bits] = 0;
+  for (unsigned int u = 0; u < unit_count; u++) {
+    memset(units[u].gray_tx[CUBE_SIZE * bits], 0, sizeof(units[u].gray_tx[0]));
+    gray_clear(units[u].gray);
+  }
+}
+
+// pack_gray splits the grayscale cube in bit-planes, maps and packs them in the grayscale frame buffer.
+static void     pack_gray(unit_t* unit) {
+  uint64_t      start = stats_start(unit->pack_stats);
+  cube_t        planes[GRAY_MAX_BITS];
   cube_t        mapped_cube;
-  cube_size_t   tx[CUBE_SIZE + 1]; // 1 row of cathodes, CUBE_SIZE rows of anodes.
+
+  // Split the intensities in bit-planes.
+  gray_decompose(unit->gray, gray_bits, planes);
+
+  // Map and pack each bit-plane.
+  for (int b = 0; b < gray_bits; b++) {
+    remap_apply(&remap, planes[b], mapped_cube);
+    for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+      pack_layer(unit->gray_tx[i * gray_bits + b], mapped_cube, i);
+    }
+  }
+  stats_stop(unit->pack_stats, start);
+}
+
+// send_gray uses SPI to display the packed grayscale frame buffer with binary code modulation.
+// Each cathode layer is displayed once per bit-plane, for a duration weighted by the bit.
+static int      send_gray(unit_t* unit) {
+  uint64_t      start = stats_start(unit->spi_stats);
   int           ret;
 
-  // Map the memory cube to the hardware.
-  map_cube(cube, mapped_cube);
+  // Send the whole frame to the SPI at once.
+  ret = spi_transfer_frame_hold(&unit->hdlr, unit->gray_tx, sizeof(unit->gray_tx[0]), CUBE_SIZE * gray_bits + 1, gray_holds);
+  stats_stop(unit->spi_stats, start);
+  return ret;
+}
 
-  // We go one cathode at the time without delay.
-  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
-    // Cathodes.
-    tx[0] = 0x01 << i;
+// pack_shared maps and packs the newest frame of the unit in the shared framebuffer, if any.
+// The frame is read in place, and only packed if the writer didn't overwrite it meanwhile.
+static void     pack_shared(unit_t* unit) {
+  shmfb_slot*   slot;
+  cube_t        mapped_cube;
+  uint64_t      start;
 
-    // Anodes.
-    for (unsigned int j = 0; j < CUBE_SIZE; j++) {
-      tx[j + 1] = mapped_cube[CUBE_SIZE - 1 - i][j];
+  while ((slot = shmfb_poll(&unit->shared))) {
+    start = stats_start(unit->pack_stats);
+    remap_apply(&remap, slot->frame, mapped_cube);
+    if (shmfb_check(&unit->shared, slot)) {
+      for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+        pack_layer(unit->tx[i], mapped_cube, i);
+      }
+      stats_stop(unit->pack_stats, start);
+      return;
     }
+  }
+}
 
-    // Send the data to the SPI.
-    if ((ret = spi_transfer(&hdlr, tx, NULL, sizeof(tx))) < 0) {
-      return ret;
+// bus_render is the refresh thread render callback, only packing changed frames.
+// Streamed frames are accounted once sent, as the main loop does without refresh threads.
+static int      bus_render(void* ctx, unsigned int changed) {
+  bus_t*        bus = ctx;
+  uint64_t*     arrival;
+  int           ret;
+
+  for (unsigned int u = 0; u < bus->count; u++) {
+    if (sharing) {
+      pack_shared(bus->units[u]);
+    } else if (changed & (1U << u)) {
+      pack_cube(bus->units[u], tribuf_front(&bus->units[u]->frames));
     }
   }
+  if ((ret = send_bus(bus)) < 0) {
+    return ret;
+  }
+  for (unsigned int u = 0; u < bus->count && ingesting; u++) {
+    arrival = &bus->units[u]->frame_arrival[bus->units[u]->frames.front];
+    if (*arrival) {
+      ingest_account(&bus->ingest_stats, clock_now_ns() - *arrival);
+      *arrival = 0;
+    }
+  }
+  return ret;
+}
+
+// Typical kernel cost of a SPI message, paid by each word when the layers of several cubes are interleaved.
+#define MESSAGE_NS 10000
+
+// set_holds holds each layer word of the unit for its configured delay, and the blank word not at all.
+static void     set_holds(unit_t* unit) {
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    unit->tx_holds[i] = unit->hdlr.config.delay;
+  }
+  unit->tx_holds[CUBE_SIZE] = 0;
+}
+
+// start_refresh hands the rendering of the bus over to a dedicated thread.
+// The per word hold time is stretched so the layers share the refresh period evenly,
+// keeping one layer slot as margin for the thread wake up: the blank word one for a single
+// cube, as it isn't held, one more when interleaved, as each blank word is held.
+static int      start_refresh(bus_t* bus, const options_t* opts, int cpu) {
+  uint64_t      word_ns = 1000000000 / opts->rate / (CUBE_SIZE + (bus->count > 1 ? 2 : 1)) / bus->count;
+  uint64_t      wire_ns = (uint64_t)(CUBE_SIZE + 1) * config.bits * 1000000000 / config.speed;
+  int           ret;
+
+  if (bus->count > 1) {
+    wire_ns += MESSAGE_NS;
+  }
 
+  for (unsigned int u = 0; u < bus->count; u++) {
+    bus->units[u]->hdlr.config.delay = word_ns > wire_ns ? (word_ns - wire_ns) / 1000 : 0;
+    set_holds(bus->units[u]);
+    tribuf_init(&bus->units[u]->frames);
+    bus->units[u]->refresh = &bus->refresh;
+    bus->refresh.frames[u] = &bus->units[u]->frames;
+  }
+  bus->refresh.count  = bus->count;
+  bus->refresh.render = bus_render;
+  bus->refresh.ctx    = bus;
+  bus->refresh.rate   = opts->rate;
+  bus->refresh.cpu    = cpu;
+  bus->refresh.fifo   = opts->fifo;
+  if ((ret = refresh_start(&bus->refresh))) {
+    fprintf(stderr, "error starting the refresh thread of bus %d: %s\n", bus->id, strerror(ret));
+    return -1;
+  }
+  return 0;
+}
+
+// add_unit sets up the SPI of a cube and adds it to its bus.
+static int      add_unit(const char* device, const spi_transport* transport) {
+  unit_t*       unit = &units[unit_count];
+  int           id;
+  int           cs;
+  unsigned int  b;
+
+  unit->hdlr.config        = config;
+  unit->hdlr.config.device = device;
+  unit->hdlr.transport     = transport;
+  set_holds(unit);
+  if (spi_setup(&unit->hdlr) < 0) {
+    perror(device);
+    return -1;
+  }
+  unit_count++;
+
+  // Devices outside of /dev/spidevN.M get a bus of their own.
+  if (sscanf(device, "/dev/spidev%d.%d", &id, &cs) != 2) {
+    id = -(int)unit_count;
+  }
+  for (b = 0; b < bus_count && buses[b].id != id; b++);
+  if (b == bus_count) {
+    buses[bus_count++].id = id;
+  }
+  buses[b].units[buses[b].count++] = unit;
   return 0;
 }
 
 // setup is called before the main loop.
 // Should return a negative value in case of error.
-int     setup() {
-  // Initialize SPI.
-  if (spi_setup(&hdlr) < 0) {
-    perror("error setting up SPI");
-    return 1;
+int                     setup(const options_t* opts) {
+  const spi_transport*  transport;
+  uint64_t              now;
+
+  // Select the SPI transport.
+  if (!(transport = spi_transport_lookup(opts->transport))) {
+    fprintf(stderr, "unknown SPI transport: %s\n", opts->transport);
+    return -1;
   }
 
-  // Seed the random generator.
-  srand(time(NULL));
+  // Compile the hardware mapping and make sure it matches the wiring tables.
+  remap_compile(&remap, x_map, y_map, z_map);
+  if (remap_verify(&remap) < 0) {
+    fprintf(stderr, "error compiling the hardware mapping\n");
+    return -1;
+  }
 
-  // Clear the cube.
-  clear_cube(cube);
+  // Select the cube kernels for this CPU.
+  fprintf(stderr, "using %s cube kernels\n", cube_kernels_init(&remap)->name);
+
+  // Initialize SPI, for each cube.
+  if (!opts->count && add_unit(config.device, transport) < 0) {
+    return -1;
+  }
+  for (unsigned int u = 0; u < opts->count; u++) {
+    if (add_unit(opts->devices[u], transport) < 0) {
+      return -1;
+    }
+  }
+
+  // Create the latency histograms if requested, before the refresh threads write them.
+  if (opts->stats) {
+    char        name[32];
+
+    if (stats_create(&stats, opts->stats, 1 + 2 * unit_count + bus_count) < 0) {
+      perror(opts->stats);
+      return -1;
+    }
+    step_stats = stats_add(&stats, "scene step");
+    for (unsigned int u = 0; u < unit_count; u++) {
+      snprintf(name, sizeof(name), "cube %u pack", u);
+      units[u].pack_stats = stats_add(&stats, name);
+      snprintf(name, sizeof(name), "cube %u spi", u);
+      units[u].spi_stats = stats_add(&stats, name);
+    }
+    for (unsigned int b = 0; b < bus_count; b++) {
+      snprintf(name, sizeof(name), "bus %d interval", buses[b].id);
+      buses[b].interval_stats = stats_add(&stats, name);
+    }
+  }
+
+  // Create the shared framebuffer if requested, before the refresh threads read it.
+  if (opts->shm) {
+    if (opts->bits || opts->play || opts->ingest) {
+      fprintf(stderr, "the shared framebuffer is on/off voxels only, instead of the scene\n");
+      return -1;
+    }
+    if (shmfb_create(&shmfb, opts->shm, unit_count, SHMFB_SLOTS) < 0) {
+      perror(opts->shm);
+      return -1;
+    }
+    for (unsigned int u = 0; u < unit_count; u++) {
+      shmfb_reader_init(&units[u].shared, &shmfb, u);
+    }
+    sharing = 1;
+  }
+
+  // Setup the grayscale mode if requested.
+  if (opts->bits) {
+    if (opts->bits < 1 || opts->bits > GRAY_MAX_BITS || opts->rate) {
+      fprintf(stderr, "grayscale supports 1 to %d bits, from the main loop only\n", GRAY_MAX_BITS);
+      return -1;
+    }
+    setup_gray(opts->bits);
+    gray_scene = wave;
+  }
+
+  // Map the baked animation if requested.
+  if (opts->play) {
+    if (opts->bits) {
+      fprintf(stderr, "baked animations are on/off voxels only\n");
+      return -1;
+    }
+    if (anim_open(&anim, opts->play) < 0) {
+      perror(opts->play);
+      return -1;
+    }
+  }
+
+  // Receive the streamed frames if requested.
+  if (opts->ingest) {
+    if (opts->bits || opts->play) {
+      fprintf(stderr, "streamed frames are on/off voxels only, instead of the scene\n");
+      return -1;
+    }
+    if (ingest_open(&ingest, opts->ingest, unit_count) < 0) {
+      perror(opts->ingest);
+      return -1;
+    }
+    ingesting = 1;
+  }
 
   // Set the scene to use.
   scene = rain;
   scene = manual;
   scene = plane_shift;
 
+  // Clear the cubes, seed and start their scenes on the same clock.
+  now = clock_now_ns();
+  for (unsigned int u = 0; u < unit_count; u++) {
+    clear_cube(units[u].cube);
+    memset(&units[u].scene, 0, sizeof(units[u].scene));
+    rng_seed(&units[u].scene.rng, (opts->seed < 0 ? time(NULL) : opts->seed) + u);
+    units[u].next_step = now;
+  }
+
+  // Start a refresh thread per bus if requested, on successive cores if pinned.
+  // Last, so no option check fails with the threads running.
+  loop_delay = config.delay;
+  if (opts->rate) {
+    for (unsigned int b = 0; b < bus_count; b++) {
+      if (start_refresh(&buses[b], opts, opts->cpu < 0 ? -1 : opts->cpu + (int)b) < 0) {
+        return -1;
+      }
+      refreshing = 1;
+    }
+  }
+
   return 0;
 }
 
+// show packs the frame, or hands it over to the refresh thread.
+// Nothing is published once the refresh thread is gone, loop() returns its error.
+static void     show(unit_t* unit, cube_t cube) {
+  if (refreshing) {
+    if (refresh_error(unit->refresh) < 0) {
+      return;
+    }
+    memcpy(tribuf_back(&unit->frames), cube, sizeof(cube_t));
+    tribuf_publish(&unit->frames);
+  } else {
+    pack_cube(unit, cube);
+  }
+}
+
+// step_scene steps the scene of the cube, or its baked animation, and schedules its next step.
+// Only changed frames get packed or published. Baked frames are packed straight from the mapping.
+static void             step_scene(unit_t* unit, uint64_t now) {
+  unsigned long         generation = cube_generation();
+  uint64_t              start      = stats_start(step_stats);
+  uint64_t              delay;
+
+  if (gray_bits) {
+    delay = gray_scene(&unit->scene, unit->gray) * 1000;
+    stats_stop(step_stats, start);
+    pack_gray(unit);
+  } else if (anim.entries) {
+    delay = (uint64_t)anim_duration(&anim, unit->anim_step) * 1000;
+    if (anim_frame(&anim, unit->anim_step) != unit->shown) {
+      unit->shown = anim_frame(&anim, unit->anim_step);
+      show(unit, unit->shown);
+    }
+    stats_stop(step_stats, start);
+    if (++unit->anim_step == anim.entries) {
+      unit->anim_step = 0;
+    }
+  } else {
+    delay = scene(&unit->scene, unit->cube) * 1000;
+    stats_stop(step_stats, start);
+    if (cube_generation() != generation) {
+      show(unit, unit->cube);
+    }
+  }
+
+  // Keep the cadence, unless we are late by more than a step.
+  unit->next_step += delay;
+  if (unit->next_step < now) {
+    unit->next_step = now + delay;
+  }
+}
+
+// ingest_frames pops the streamed frames due and shows, for each cube, the latest one.
+// Frames older than the last one taken, or due too long ago, are dropped as late.
+// Frames are expected in presentation order, so the first one not due yet ends the pass.
+// Returns the presentation time of that frame, UINT64_MAX if the ring is empty.
+static uint64_t         ingest_frames(uint64_t now) {
+  const ingest_slot*    slot;
+  unit_t*               unit;
+  uint64_t              next = UINT64_MAX;
+  unsigned int          due  = 0;
+
+  while ((slot = ingest_peek(&ingest))) {
+    if (slot->packet.pts_ns > now) {
+      next = slot->packet.pts_ns;
+      break;
+    }
+    unit = &units[slot->packet.unit];
+    if (slot->packet.seq <= unit->ingest_seq || (slot->packet.pts_ns && slot->packet.pts_ns + INGEST_MAX_LATE_NS < now)) {
+      ingest.stats.late++;
+    } else {
+      if (due & (1U << slot->packet.unit)) {
+        ingest.stats.superseded++;
+      }
+      due                 |= 1U << slot->packet.unit;
+      unit->ingest_seq     = slot->packet.seq;
+      unit->ingest_arrival = slot->packet.pts_ns > slot->arrival_ns ? slot->packet.pts_ns : slot->arrival_ns;
+      memcpy(unit->cube, slot->packet.frame, sizeof(cube_t));
+    }
+    ingest_pop(&ingest);
+  }
+
+  // Hand them over. The refresh threads pick them up on their next period, and account them once sent.
+  for (unsigned int u = 0; u < unit_count; u++) {
+    if (due & (1U << u)) {
+      if (refreshing) {
+        units[u].frame_arrival[units[u].frames.back] = units[u].ingest_arrival;
+        units[u].ingest_arrival = 0;
+      }
+      show(&units[u], units[u].cube);
+    }
+  }
+  return next;
+}
+
 // loop is the main logic block, called by the main.
 // Should return a negative value in case of error.
-int     loop() {
-  int   ret;
+int             loop() {
+  uint64_t      now       = clock_now_ns();
+  uint64_t      next_step = UINT64_MAX;
+  int           ret;
 
-  // Step the scene.
-  scene(cube);
+  // Give up if a refresh thread exited on a render error.
+  for (unsigned int b = 0; b < bus_count && refreshing; b++) {
+    if ((ret = refresh_error(&buses[b].refresh)) < 0) {
+      fprintf(stderr, "refresh thread of bus %d exited on error\n", buses[b].id);
+      return ret;
+    }
+  }
 
-  // Render it.
-  if ((ret = render_cube(hdlr, cube)) < 0) {
-    return ret;
+  // Step the scenes when due, all on the same clock, unless frames are streamed.
+  if (ingesting) {
+    next_step = ingest_frames(now);
+  }
+  for (unsigned int u = 0; u < unit_count && !ingesting && !sharing; u++) {
+    if (now >= units[u].next_step) {
+      step_scene(&units[u], now);
+    }
+    if (units[u].next_step < next_step) {
+      next_step = units[u].next_step;
+    }
+  }
+
+  // When the refresh threads read the shared framebuffer, there is nothing to do.
+  if (refreshing && sharing) {
+    clock_sleep_until(now + SHARED_IDLE_NS);
+    return 0;
+  }
+
+  // When the refresh threads render streamed frames, wait for the next one due, or received.
+  if (refreshing && ingesting) {
+    if (next_step == UINT64_MAX) {
+      ingest_wait(&ingest, INGEST_IDLE_NS);
+    } else {
+      clock_sleep_until(next_step);
+    }
+    return 0;
+  }
+
+  // When the refresh threads render, just wait for the next step.
+  if (refreshing) {
+    clock_sleep_until(next_step);
+    return 0;
+  }
+
+  // Render them.
+  if (gray_bits) {
+    for (unsigned int u = 0; u < unit_count; u++) {
+      if ((ret = send_gray(&units[u])) < 0) {
+        return ret;
+      }
+    }
+  } else {
+    for (unsigned int u = 0; u < unit_count && sharing; u++) {
+      pack_shared(&units[u]);
+    }
+    for (unsigned int b = 0; b < bus_count; b++) {
+      if ((ret = send_bus(&buses[b])) < 0) {
+        return ret;
+      }
+    }
+  }
+
+  // Account for the streamed frames just sent.
+  for (unsigned int u = 0; u < unit_count && ingesting; u++) {
+    if (units[u].ingest_arrival) {
+      ingest_account(&ingest.stats, clock_now_ns() - units[u].ingest_arrival);
+      units[u].ingest_arrival = 0;
+    }
   }
 
   // Delay and repeat.
-  usleep(hdlr.config.delay);
+  usleep(loop_delay);
   return 0;
 }
 
 // cleanup is callled when the main loop exits.
 // Should return a negative value in case of error.
 int     cleanup() {
+  char  name[32];
   int   ret;
 
-  // Turn off the cube.
-  clear_cube(cube);
-  render_cube(hdlr, cube);
+  // Stop the refresh threads.
+  for (unsigned int b = 0; b < bus_count; b++) {
+    if (buses[b].refresh.running) {
+      // errno belongs to the refresh thread, the render error is all we have.
+      if ((ret = refresh_stop(&buses[b].refresh)) < 0) {
+        fprintf(stderr, "error refreshing the cubes of bus %d\n", buses[b].id);
+      }
+      snprintf(name, sizeof(name), "refresh bus %d", buses[b].id);
+      refresh_report(&buses[b].refresh, name, stderr);
+    }
+  }
+
+  // Stop receiving frames.
+  if (ingesting) {
+    ingest_close(&ingest);
+    for (unsigned int b = 0; b < bus_count; b++) {
+      ingest_merge(&ingest.stats, &buses[b].ingest_stats);
+    }
+    ingest_report(&ingest, stderr);
+  }
+
+  // Stop reading the shared framebuffer.
+  if (sharing) {
+    for (unsigned int u = 0; u < unit_count; u++) {
+      snprintf(name, sizeof(name), "shared cube %u", u);
+      shmfb_report(&units[u].shared, name, stderr);
+    }
+    shmfb_close(&shmfb);
+    sharing = 0;
+  }
+
+  // Turn off the cubes.
+  for (unsigned int b = 0; b < bus_count; b++) {
+    for (unsigned int u = 0; u < buses[b].count; u++) {
+      clear_cube(buses[b].units[u]->cube);
+      pack_cube(buses[b].units[u], buses[b].units[u]->cube);
+    }
+    send_bus(&buses[b]);
+  }
+
+  // Print and remove the latency histograms.
+  if (stats.shm.map) {
+    stats_print(&stats, stderr);
+    stats_close(&stats);
+  }
+
+  // Unmap the baked animation.
+  anim_close(&anim);
 
   // Cleanup SPI.
-  if ((ret = spi_cleanup(&hdlr)) < 0) {
-    perror("error cleaning up SPI");
-    return ret;
+  for (unsigned int u = 0; u < unit_count; u++) {
+    if ((ret = spi_cleanup(&units[u].hdlr)) < 0) {
+      perror("error cleaning up SPI");
+      return ret;
+    }
   }
 
   return 0;
@@ -1,6 +1,14 @@
+#define _DEFAULT_SOURCE // For getopt(3) (fix warning on linux).
 #include <sys/signal.h> // signal(2) & co.
+#include <sched.h>      // sched_get_priority_min(2), sched_get_priority_max(2).
+#include <stdio.h>      // fprintf(3).
+#include <stdlib.h>     // strtol(3), strtoll(3).
+#include <unistd.h>     // getopt(3), sysconf(3).
 
-int setup();
+#include "options.h"    // options_t.
+#include "gray.h"       // GRAY_MAX_BITS.
+
+int setup(const options_t* opts);
 int loop();
 int cleanup();
 
@@ -10,20 +18,123 @@ static void intHandler() {
     _running = 0;
 }
 
-int     main() {
+static void     usage(const char* name) {
+  fprintf(stderr, "usage: %s [-d device]... [-t transport] [-r rate [-c cpu] [-f priority] | -g bits] [-p file | -i address | -m name] [-s name] [-S seed]\n", name);
+  fprintf(stderr, "  -d device     SPI device of a cube, repeat for up to %d cubes (default /dev/spidev0.0).\n", OPTIONS_MAX_DEVICES);
+  fprintf(stderr, "  -t transport  SPI transport: spidev (default), spidev-wo, write, gpio, file, sim.\n");
+  fprintf(stderr, "  -r rate       Refresh from a dedicated thread per SPI bus at rate Hz, 1 to %d.\n", OPTIONS_MAX_RATE);
+  fprintf(stderr, "  -c cpu        Pin the refresh threads to the given core and the next ones.\n");
+  fprintf(stderr, "  -f priority   Run the refresh thread with SCHED_FIFO at the given priority, %d to %d.\n",
+          sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+  fprintf(stderr, "  -g bits       Run the grayscale scene with bits per voxel, 1 to %d.\n", GRAY_MAX_BITS);
+  fprintf(stderr, "  -p file       Play the baked animation in loop instead of the scene.\n");
+  fprintf(stderr, "  -i address    Show the frames streamed to udp:[host:]port or unix:path instead of the scene.\n");
+  fprintf(stderr, "  -m name       Show the frames written to the shared framebuffer /dev/shm/name instead of the scene.\n");
+  fprintf(stderr, "  -s name       Publish the latency histograms in /dev/shm/name, see cubestat.\n");
+  fprintf(stderr, "  -S seed       Seed of the scenes, for reproducible runs (default: time).\n");
+}
+
+// parse_int parses a whole decimal argument within min and max, -1 if it isn't one.
+static int      parse_int(const char* arg, long min, long max, int* value) {
+  char*         end;
+  long          n = strtol(arg, &end, 10);
+
+  if (end == arg || *end || n < min || n > max) {
+    return -1;
+  }
+  *value = n;
+  return 0;
+}
+
+int             main(int argc, char** argv) {
+  options_t     opts = {
+    .count     = 0,
+    .transport = "spidev",
+    .rate      = 0,
+    .cpu       = -1,
+    .fifo      = 0,
+    .bits      = 0,
+    .play      = NULL,
+    .ingest    = NULL,
+    .shm       = NULL,
+    .stats     = NULL,
+    .seed      = -1,
+  };
+  int           opt;
+  int           rate;
+  int           ret;
+
+  while ((opt = getopt(argc, argv, "d:t:r:c:f:g:p:i:m:s:S:")) != -1) {
+    switch (opt) {
+    case 'd':
+      if (opts.count == OPTIONS_MAX_DEVICES) {
+        usage(argv[0]);
+        return 1;
+      }
+      opts.devices[opts.count++] = optarg;
+      break;
+    case 't':
+      opts.transport = optarg;
+      break;
+    case 'r':
+      if (parse_int(optarg, 1, OPTIONS_MAX_RATE, &rate) < 0) {
+        usage(argv[0]);
+        return 1;
+      }
+      opts.rate = rate;
+      break;
+    case 'c':
+      if (parse_int(optarg, 0, sysconf(_SC_NPROCESSORS_CONF) - 1, &opts.cpu) < 0) {
+        usage(argv[0]);
+        return 1;
+      }
+      break;
+    case 'f':
+      if (parse_int(optarg, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO), &opts.fifo) < 0) {
+        usage(argv[0]);
+        return 1;
+      }
+      break;
+    case 'g':
+      if (parse_int(optarg, 1, GRAY_MAX_BITS, &opts.bits) < 0) {
+        usage(argv[0]);
+        return 1;
+      }
+      break;
+    case 'p':
+      opts.play = optarg;
+      break;
+    case 'i':
+      opts.ingest = optarg;
+      break;
+    case 'm':
+      opts.shm = optarg;
+      break;
+    case 's':
+      opts.stats = optarg;
+      break;
+    case 'S':
+      opts.seed = strtoll(optarg, NULL, 10);
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
    signal(SIGINT, intHandler);
    signal(SIGTERM, intHandler);
 
-  if (setup() < 0) {
+  if (setup(&opts) < 0) {
     return 1;
   }
 
   // Main loop.
-  while (loop() >= 0 && _running);
+  while ((ret = loop()) >= 0 && _running);
 
   if (cleanup() < 0) {
     return 1;
   }
 
-  return 0;
+  return ret < 0 ? 1 : 0;
 }
@@ -0,0 +1,26 @@
+#ifndef __OPTIONS_H__
+# define __OPTIONS_H__
+
+// Maximum number of cubes, one per SPI device.
+# define OPTIONS_MAX_DEVICES 8
+
+// Maximum refresh rate (Hz), the layer words wouldn't fit in the refresh period above.
+# define OPTIONS_MAX_RATE 100000
+
+// Runtime options, set from the command line.
+typedef struct {
+    const char*     devices[OPTIONS_MAX_DEVICES]; // SPI device of each cube.
+    unsigned int    count;                        // Number of cubes, 0 for the default device.
+    const char*     transport; // SPI transport name, see spi_transport_lookup.
+    unsigned int    rate;      // Refresh rate (Hz) of the refresh threads, 0 to render from the main loop.
+    int             cpu;       // Core to pin the first refresh thread to, the next ones on the next cores, -1 to not pin.
+    int             fifo;      // SCHED_FIFO priority of the refresh thread, 0 to keep the default policy.
+    int             bits;      // Bits per voxel of the grayscale mode, 0 for on/off voxels.
+    const char*     play;      // Baked animation to play in loop instead of the scene, NULL for none.
+    const char*     shm;       // Shared memory framebuffer to create and show instead of the scene, see shmfb.h, NULL for none.
+    const char*     ingest;    // Address to receive streamed frames on instead of the scene, see ingest_address, NULL for none.
+    const char*     stats;     // Shared memory object to publish the latency histograms in, see stats.h, NULL for none.
+    long long       seed;      // Seed of the scene of the first cube, the next cubes get the next seeds, -1 for the time.
+}                   options_t;
+
+#endif /* !__OPTIONS_H__ */
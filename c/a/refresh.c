@@ -0,0 +1,132 @@
+#define _GNU_SOURCE // For pthread_attr_setaffinity_np(3).
+#include <errno.h>  // errno(3).
+#include <math.h>   // sqrt(3).
+#include <sched.h>  // cpu_set_t, SCHED_FIFO.
+
+#include "refresh.h"
+#include "clock.h"  // clock_now_ns, clock_sleep_until.
+
+// run is the refresh thread.
+static void*            run(void* arg) {
+  refresh_t*            refresh = arg;
+  refresh_stats*        stats   = &refresh->stats;
+  uint64_t              period  = NSEC_PER_SEC / refresh->rate;
+  uint64_t              deadline = clock_now_ns();
+  uint64_t              now;
+  uint64_t              latency;
+  unsigned int          changed = (1U << refresh->count) - 1;
+
+  while (refresh->running) {
+    // Display the latest frames.
+    for (unsigned int i = 0; i < refresh->count; i++) {
+      changed |= tribuf_swap(refresh->frames[i]) << i;
+    }
+    if ((refresh->ret = refresh->render(refresh->ctx, changed)) < 0) {
+      break;
+    }
+    changed = 0;
+
+    // Wait for the next deadline.
+    deadline += period;
+    while (clock_sleep_until(deadline) == EINTR);
+
+    // Account for the wake up latency.
+    now     = clock_now_ns();
+    latency = now > deadline ? now - deadline : 0;
+    if (!stats->frames || latency < stats->min_ns) {
+      stats->min_ns = latency;
+    }
+    if (latency > stats->max_ns) {
+      stats->max_ns = latency;
+    }
+    stats->sum_ns  += latency;
+    stats->sum2_ns += (double)latency * latency;
+    stats->frames++;
+
+    // If we missed a whole period, don't try to catch up.
+    if (latency > period) {
+      stats->late++;
+      deadline = now;
+    }
+  }
+
+  // Publish ret along with the flag, the main loop reads it as soon as it sees the flag.
+  __atomic_store_n(&refresh->stopped, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+// refresh_start spawns the refresh thread.
+// Returns a positive errno value on failure.
+int                     refresh_start(refresh_t* refresh) {
+  pthread_attr_t        attr;
+  int                   ret;
+
+  if (!refresh->rate || !refresh->count || refresh->count > REFRESH_MAX_FRAMES) {
+    return EINVAL;
+  }
+
+  pthread_attr_init(&attr);
+
+  // Pin to the given core.
+  if (refresh->cpu >= 0) {
+    cpu_set_t           cpus;
+
+    CPU_ZERO(&cpus);
+    CPU_SET(refresh->cpu, &cpus);
+    if ((ret = pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus))) {
+      goto out;
+    }
+  }
+
+  // Run with the real-time scheduler.
+  if (refresh->fifo > 0) {
+    struct sched_param  param = { .sched_priority = refresh->fifo };
+
+    if ((ret = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED)) ||
+        (ret = pthread_attr_setschedpolicy(&attr, SCHED_FIFO)) ||
+        (ret = pthread_attr_setschedparam(&attr, &param))) {
+      goto out;
+    }
+  }
+
+  refresh->running = 1;
+  refresh->stopped = 0;
+  refresh->ret     = 0;
+  if ((ret = pthread_create(&refresh->thread, &attr, run, refresh))) {
+    refresh->running = 0;
+  }
+
+ out:
+  pthread_attr_destroy(&attr);
+  return ret;
+}
+
+// refresh_stop waits for the refresh thread to exit.
+// Returns the render error, if any.
+int     refresh_stop(refresh_t* refresh) {
+  refresh->running = 0;
+  pthread_join(refresh->thread, NULL);
+  return refresh->ret;
+}
+
+// refresh_error tells whether the refresh thread exited on its own.
+// Returns the render error it exited on, 0 while it runs. Cheap enough to call on every step.
+int     refresh_error(const refresh_t* refresh) {
+  if (!__atomic_load_n(&refresh->stopped, __ATOMIC_ACQUIRE) || !refresh->running) {
+    return 0;
+  }
+  return refresh->ret < 0 ? refresh->ret : -1;
+}
+
+// refresh_report prints the refresh rate and the wake up jitter.
+void                    refresh_report(const refresh_t* refresh, const char* name, FILE* out) {
+  const refresh_stats*  stats = &refresh->stats;
+  double                n     = stats->frames ? stats->frames : 1;
+  double                mean  = stats->sum_ns / n;
+  double                var   = stats->sum2_ns / n - mean * mean;
+
+  fprintf(out, "%s: %llu frames at %u Hz, %llu late\n",
+          name, (unsigned long long)stats->frames, refresh->rate, (unsigned long long)stats->late);
+  fprintf(out, "%s: wake up latency min %.1f us, mean %.1f us, max %.1f us, stddev %.1f us\n",
+          name, stats->min_ns / 1e3, mean / 1e3, stats->max_ns / 1e3, (var > 0 ? sqrt(var) : 0) / 1e3);
+}
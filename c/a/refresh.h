@@ -0,0 +1,66 @@
+#ifndef __REFRESH_H__
+# define __REFRESH_H__
+
+# include <pthread.h> // pthread_t.
+# include <stdint.h>  // uint64_t.
+# include <stdio.h>   // FILE.
+
+# include "cube.h"    // cube_t.
+# include "tribuf.h"  // tribuf_t.
+
+/**
+   Dedicated refresh thread, only doing the layer multiplexing.
+
+   Each period, the thread takes the latest frames published in the triple buffers
+   and renders them, then sleeps until the next absolute deadline. The render callback
+   is told which frames changed since the previous call, so it can skip packing.
+   A thread drives all the cubes of a SPI bus, one frame per cube.
+
+   Example:
+
+   refresh_t     refresh = {
+     .render = render,     // Called with ctx and the bitmask of the changed frames.
+     .ctx    = &bus,
+     .frames = { &frames }, // Published by the scene side, front displayed.
+     .count  = 1,
+     .rate   = 1000,       // 1kHz.
+     .cpu    = 3,          // Pinned to the 4th core, -1 to not pin.
+     .fifo   = 50,         // SCHED_FIFO priority, 0 to keep the default policy.
+   };
+*/
+
+// Maximum number of frames refreshed by a thread.
+# define REFRESH_MAX_FRAMES 8
+
+typedef struct {
+    uint64_t    frames;    // Number of refreshes.
+    uint64_t    late;      // Number of missed deadlines.
+    uint64_t    min_ns;    // Minimum wake up latency.
+    uint64_t    max_ns;    // Maximum wake up latency.
+    uint64_t    sum_ns;    // Sum of wake up latencies.
+    double      sum2_ns;   // Sum of squared wake up latencies.
+}               refresh_stats;
+
+typedef struct {
+    int             (*render)(void* ctx, unsigned int changed);
+    void*           ctx;
+    tribuf_t*       frames[REFRESH_MAX_FRAMES];
+    unsigned int    count;
+    unsigned int    rate;
+    int             cpu;
+    int             fifo;
+
+    // Private.
+    pthread_t       thread;
+    volatile int    running;
+    int             stopped; // Set with release semantics once ret is final.
+    int             ret;
+    refresh_stats   stats;
+}                   refresh_t;
+
+int     refresh_start(refresh_t* refresh);
+int     refresh_stop(refresh_t* refresh);
+int     refresh_error(const refresh_t* refresh);
+void    refresh_report(const refresh_t* refresh, const char* name, FILE* out);
+
+#endif /* !__REFRESH_H__ */
@@ -0,0 +1,159 @@
+#include <string.h> // memset(3), memcmp(3).
+
+#include "remap.h"
+#include "kernels.h" // cube_kernels.
+
+// remap_compile builds the byte permutation and X LUTs from the wiring tables.
+void                    remap_compile(remap_t* remap, const wiring_t x_map, const wiring_t y_map, const wiring_t z_map) {
+  unsigned int          nluts = 0;
+
+  memset(remap, 0, sizeof(*remap));
+  remap->x_map       = x_map;
+  remap->y_map       = y_map;
+  remap->z_map       = z_map;
+  remap->separable   = 1;
+  remap->permutation = 1;
+
+  for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+    for (unsigned int z = 0; z < CUBE_SIZE; z++) {
+      unsigned int      src = (CUBE_SIZE - 1 - y) * CUBE_SIZE + (CUBE_SIZE - 1 - z);
+      int               yy  = y_map[0][y];
+      int               zz  = z_map[0][z];
+      unsigned int      i;
+
+      // The whole X row has to land in the same destination byte.
+      for (unsigned int x = 1; x < CUBE_SIZE; x++) {
+        if (y_map[x][y] != yy || z_map[x][z] != zz) {
+          remap->separable = 0;
+          return;
+        }
+      }
+      remap->dst[src] = (CUBE_SIZE - 1 - yy) * CUBE_SIZE + (CUBE_SIZE - 1 - zz);
+
+      // Reuse the LUT of a previous row with the same X wiring.
+      for (i = 0; i < nluts; i++) {
+        unsigned int    x;
+
+        for (x = 0; x < CUBE_SIZE && remap->luts[i][0x01 << x] == (0x01 << x_map[z][x]); x++);
+        if (x == CUBE_SIZE) {
+          break;
+        }
+      }
+      if (i == nluts) {
+        for (unsigned int b = 0; b < 256; b++) {
+          for (unsigned int x = 0; x < CUBE_SIZE; x++) {
+            if (b & (0x01 << x)) {
+              remap->luts[i][b] |= 0x01 << x_map[z][x];
+            }
+          }
+        }
+        nluts++;
+      }
+      remap->lut[src] = remap->luts[i];
+    }
+  }
+
+  // Check if some destination bytes get merged from several sources.
+  for (unsigned int i = 0; i < CUBE_SIZE * CUBE_SIZE; i++) {
+    for (unsigned int j = i + 1; j < CUBE_SIZE * CUBE_SIZE; j++) {
+      if (remap->dst[i] == remap->dst[j]) {
+        remap->permutation = 0;
+      }
+    }
+  }
+  if (!remap->permutation) {
+    return;
+  }
+
+  // Build the SIMD tables if each X row is kept or reversed.
+  remap->simd = 1;
+  memset(remap->shuffle, 0x80, sizeof(remap->shuffle));
+  for (unsigned int i = 0; i < CUBE_SIZE * CUBE_SIZE; i++) {
+    unsigned int        d        = remap->dst[i];
+    int                 kept     = 1;
+    int                 reversed = 1;
+
+    for (unsigned int x = 0; x < CUBE_SIZE; x++) {
+      kept     &= remap->lut[i][0x01 << x] == (0x01 << x);
+      reversed &= remap->lut[i][0x01 << x] == (0x01 << (CUBE_SIZE - 1 - x));
+    }
+    if (!kept && !reversed) {
+      remap->simd = 0;
+      return;
+    }
+    remap->shuffle[i / 16][d / 16][d % 16] = i % 16;
+    remap->reverse[d]                      = kept ? 0x00 : 0xFF;
+  }
+}
+
+// remap_apply maps src to dst to match the hardware wiring, with the selected kernels.
+void    remap_apply(const remap_t* remap, cube_t src, cube_t dst) {
+  cube_kernels->remap(remap, src, dst);
+}
+
+// remap_apply_scalar maps src to dst to match the hardware wiring, with the byte LUTs.
+void                    remap_apply_scalar(const remap_t* remap, cube_t src, cube_t dst) {
+  const cube_size_t*    in  = &src[0][0];
+  cube_size_t*          out = &dst[0][0];
+
+  if (!remap->separable) {
+    remap_reference(remap, src, dst);
+    return;
+  }
+
+  if (remap->permutation) {
+    for (unsigned int i = 0; i < CUBE_SIZE * CUBE_SIZE; i++) {
+      out[remap->dst[i]] = remap->lut[i][in[i]];
+    }
+    return;
+  }
+
+  memset(dst, 0, sizeof(cube_t));
+  for (unsigned int i = 0; i < CUBE_SIZE * CUBE_SIZE; i++) {
+    out[remap->dst[i]] |= remap->lut[i][in[i]];
+  }
+}
+
+// remap_reference maps src to dst one voxel at the time.
+void    remap_reference(const remap_t* remap, cube_t src, cube_t dst) {
+  // Make sure the dst is cleared, without bumping the generation as it may run
+  // from the refresh threads.
+  memset(dst, 0, sizeof(cube_t));
+
+  // For each point of the cube, map x/y/z to match the defined hardware wiring.
+  for (unsigned int x = 0; x < CUBE_SIZE; x++) {
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      for (unsigned int z = 0; z < CUBE_SIZE; z++) {
+	if (get_voxel(src, x, y, z)) {
+	  int xx = remap->x_map[z][x];
+	  int yy = remap->y_map[x][y];
+	  int zz = remap->z_map[x][z];
+	  dst[CUBE_SIZE - 1 - yy][CUBE_SIZE - 1 - zz] |= 0x01 << xx;
+	}
+      }
+    }
+  }
+}
+
+// remap_verify checks remap_apply against remap_reference for each voxel.
+// As both are linear, it covers any cube. Returns -1 on mismatch.
+int             remap_verify(const remap_t* remap) {
+  cube_t        src;
+  cube_t        got;
+  cube_t        want;
+
+  for (unsigned int x = 0; x < CUBE_SIZE; x++) {
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      for (unsigned int z = 0; z < CUBE_SIZE; z++) {
+        clear_cube(src);
+        set_voxel(src, x, y, z);
+        remap_apply(remap, src, got);
+        remap_reference(remap, src, want);
+        if (memcmp(got, want, sizeof(cube_t))) {
+          return -1;
+        }
+      }
+    }
+  }
+  return 0;
+}
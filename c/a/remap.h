@@ -0,0 +1,52 @@
+#ifndef __REMAP_H__
+# define __REMAP_H__
+
+# include <stdint.h> // uint8_t.
+
+# include "cube.h"   // cube_t.
+
+// Wiring table, see loop.c for the layout of each axis.
+typedef int     wiring_t[CUBE_SIZE][CUBE_SIZE];
+
+/**
+   remap_t is the hardware wiring compiled into a fixed byte permutation.
+
+   When every source byte (a X row for a given y/z) lands in a single destination
+   byte, the remap is a byte shuffle plus a per byte bit permutation LUT for X.
+   Otherwise, it falls back to the per voxel mapping.
+
+   When the shuffle is a permutation and each X row is either kept or reversed,
+   the SIMD kernels run it as 16 bytes lane shuffles and a masked bit reversal.
+*/
+typedef struct {
+    const int       (*x_map)[CUBE_SIZE];            // X wiring on Z axis.
+    const int       (*y_map)[CUBE_SIZE];            // Y wiring on X axis.
+    const int       (*z_map)[CUBE_SIZE];            // Z wiring on X axis.
+    int             separable;                      // Each source byte goes to a single destination byte.
+    int             permutation;                    // Each destination byte has a single source byte.
+    uint8_t         dst[CUBE_SIZE * CUBE_SIZE];     // Destination byte of each source byte.
+    const uint8_t*  lut[CUBE_SIZE * CUBE_SIZE];     // X bit permutation of each source byte.
+    uint8_t         luts[CUBE_SIZE * CUBE_SIZE][256]; // Distinct X bit permutations.
+    int             simd;                           // Runnable by the SIMD kernels.
+    uint8_t         shuffle[4][4][16];              // Source lane j byte of each output lane k byte, 0x80 for none.
+    uint8_t         reverse[CUBE_SIZE * CUBE_SIZE]; // 0xFF for the output bytes to bit-reverse.
+}                   remap_t;
+
+void    remap_compile(remap_t* remap, const wiring_t x_map, const wiring_t y_map, const wiring_t z_map);
+void    remap_apply(const remap_t* remap, cube_t src, cube_t dst);
+void    remap_apply_scalar(const remap_t* remap, cube_t src, cube_t dst);
+void    remap_reference(const remap_t* remap, cube_t src, cube_t dst);
+int     remap_verify(const remap_t* remap);
+
+// pack_layer fills the SPI word displaying the ith cathode layer of the mapped cube.
+static inline void pack_layer(cube_size_t word[CUBE_SIZE + 1], cube_t mapped_cube, unsigned int i) {
+  // Cathodes.
+  word[0] = 0x01 << i;
+
+  // Anodes.
+  for (unsigned int j = 0; j < CUBE_SIZE; j++) {
+    word[j + 1] = mapped_cube[CUBE_SIZE - 1 - i][j];
+  }
+}
+
+#endif /* !__REMAP_H__ */
@@ -0,0 +1,40 @@
+#include "rng.h"
+
+// splitmix64 returns the next output of the SplitMix64 generator, to expand a seed.
+static uint64_t splitmix64(uint64_t* state) {
+  uint64_t      z = (*state += 0x9e3779b97f4a7c15ULL);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// rng_seed sets the generator state from the seed, the same seed giving the same numbers.
+void    rng_seed(rng_t* rng, uint64_t seed) {
+  for (unsigned int i = 0; i < 4; i++) {
+    rng->s[i] = splitmix64(&seed);
+  }
+}
+
+// rng_mask returns 64 random bits, each set with probability density / RNG_DENSITY_ONE.
+//
+// Going through the bits of the density from the lowest set one, OR-ing a random word
+// in for a 1 and AND-ing one for a 0 halves the probability of a bit and adds the
+// density bit as its new half: after the top bit it's the density. That's at most
+// RNG_DENSITY_BITS random words, fewer for rounder densities (one for 1/2, four for 1/16).
+uint64_t        rng_mask(rng_t* rng, unsigned int density) {
+  uint64_t      mask = 0;
+
+  if (!density) {
+    return 0;
+  }
+  if (density >= RNG_DENSITY_ONE) {
+    return ~0ULL;
+  }
+  for (unsigned int bit = __builtin_ctz(density); bit < RNG_DENSITY_BITS; bit++) {
+    uint64_t    r = rng_next(rng);
+
+    mask = (density >> bit) & 0x01 ? mask | r : mask & r;
+  }
+  return mask;
+}
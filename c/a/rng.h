@@ -0,0 +1,56 @@
+#ifndef __RNG_H__
+# define __RNG_H__
+
+# include <stdint.h> // uint64_t & co.
+
+/**
+   Seedable pseudo random generator of the scenes, xoshiro256** by Blackman and Vigna.
+
+   Each scene instance has its own, so runs from the same seed step the same and
+   several cubes or threads don't share any state. A step is a few shifts, rotates
+   and xors, without division nor lock, and yields 64 bits at once, so random voxel
+   masks come a whole layer per call.
+
+   Example:
+
+   rng_seed(&scene.rng, 42);
+   set_layer(cube, CUBE_SIZE - 1, rng_mask(&scene.rng, RNG_DENSITY_ONE / 16));
+*/
+
+// Densities of rng_mask are in 1/RNG_DENSITY_ONE.
+# define RNG_DENSITY_BITS 8
+# define RNG_DENSITY_ONE  (1 << RNG_DENSITY_BITS)
+
+typedef struct {
+    uint64_t        s[4];
+}                   rng_t;
+
+// rng_rotl rotates x left by k bits.
+static inline uint64_t  rng_rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+// rng_next returns the next 64 random bits.
+static inline uint64_t  rng_next(rng_t* rng) {
+  uint64_t              result = rng_rotl(rng->s[1] * 5, 7) * 9;
+  uint64_t              t      = rng->s[1] << 17;
+
+  rng->s[2] ^= rng->s[0];
+  rng->s[3] ^= rng->s[1];
+  rng->s[1] ^= rng->s[2];
+  rng->s[0] ^= rng->s[3];
+  rng->s[2] ^= t;
+  rng->s[3]  = rng_rotl(rng->s[3], 45);
+  return result;
+}
+
+// rng_below returns a random number in [0, n), by multiply and shift rather than
+// modulo. The bias is below n / 2^32.
+static inline uint32_t  rng_below(rng_t* rng, uint32_t n) {
+  return ((rng_next(rng) >> 32) * n) >> 32;
+}
+
+void            rng_seed(rng_t* rng, uint64_t seed);
+uint64_t        rng_mask(rng_t* rng, unsigned int density);
+
+#endif /* !__RNG_H__ */
@@ -1,36 +1,28 @@
-#include <stdlib.h> // rand(3).
-
 #include <stdio.h>
-#include "cube.h" // cube_t & co.
-
-int step = 0;
-int timer = 0;
+#include "scenes.h" // scene_t, cube_t & co.
 
-int xxx = 0;
-int yyy = 0;
-int zzz = 0;
+// Delay in between steps (usec).
+#define MANUAL_DELAY 250000
 
 // manual is a scene.
-void            manual(cube_t cube) {
-  timer++;
-  if (timer < 500) {
-    return;
-  }
+long            manual(scene_t* scene, cube_t cube) {
+  int*          xxx = &scene->state.manual.x;
+  int*          yyy = &scene->state.manual.y;
+  int*          zzz = &scene->state.manual.z;
 
-  timer = 0;
   clear_cube(cube);
-  xxx = 6;
-  set_voxel(cube, xxx, yyy, zzz);
-  printf("%d %d %d\n", xxx, yyy, zzz);
-  // set_voxel(cube, step % 8, 0, 1);
-  step++;
-
-    if (++zzz == 8) {
-    zzz = 0;
-    if (++yyy ==  8) {
-      yyy = 0;
-      if (++xxx == 8) {
-	xxx = 0;
+  *xxx = 6;
+  set_voxel(cube, *xxx, *yyy, *zzz);
+  printf("%d %d %d\n", *xxx, *yyy, *zzz);
+  // set_voxel(cube, scene->state.manual.step % 8, 0, 1);
+  scene->state.manual.step++;
+
+    if (++*zzz == 8) {
+    *zzz = 0;
+    if (++*yyy ==  8) {
+      *yyy = 0;
+      if (++*xxx == 8) {
+	*xxx = 0;
       }
     }
   }
@@ -42,7 +34,7 @@ void            manual(cube_t cube) {
   /*   printf("\n"); */
   /* } */
   /* printf("\n"); */
-  return;
+  return MANUAL_DELAY;
 
   cube_t        manual_cube[CUBE_SIZE] = {
     {{0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0}},
@@ -64,4 +56,6 @@ void            manual(cube_t cube) {
       }
     }
   }
+
+  return MANUAL_DELAY;
 }
@@ -1,23 +1,15 @@
-#include <stdlib.h> // rand(3).
-
-#include "cube.h" // cube_t & co.
-
-typedef struct {
-  axis_t        axis;
-  shift_dir_t   direction;
-  int           position;
-}               plane_t;
+#include "scenes.h" // scene_t, plane_t.
 
 // new_plane clears the cube and sets a new random plane.
-static plane_t  new_plane() {
+static plane_t  new_plane(rng_t* rng) {
   plane_t       plane;
 
-  plane.axis = rand() % 3; // Select a random axis.
+  plane.axis = rng_below(rng, 3); // Select a random axis.
 
   // Select a random edge.
-  // % 2 is 0 or 1,
+  // rng_below(rng, 2) is 0 or 1,
   // then * CUBE_SIZE - 1 is 0 or CUBE_SIZE - 1, i.e., first or last).
-  plane.position = rand() % 2 * (CUBE_SIZE - 1);
+  plane.position = rng_below(rng, 2) * (CUBE_SIZE - 1);
 
   // Choose a direction based on the axis/position.
   switch (plane.axis) {
@@ -47,37 +39,29 @@ static plane_t  new_plane() {
   return plane;
 }
 
+// Delay in between steps (usec).
+#define PLANE_SHIFT_DELAY 100000
+
 // plane_shift is a scene.
-void                    plane_shift(cube_t cube) {
-  static char           loading = 1;
-  static char           looped  = 0;
-  static unsigned int   timer   = 0;
-  static plane_t        plane;
+long            plane_shift(scene_t* scene, cube_t cube) {
+  plane_t*      plane = &scene->state.plane_shift.plane;
 
   // If we are loading, initialize the scenario.
-  if (loading) {
-    plane = new_plane();                         // Create a new plane.
-    clear_cube(cube);                            // Make sure to have a clean slate.
-    set_plane(cube, plane.axis, plane.position); // Populate the cube with the new plane.
+  if (!scene->state.plane_shift.loaded) {
+    *plane = new_plane(&scene->rng);              // Create a new plane.
+    clear_cube(cube);                              // Make sure to have a clean slate.
+    set_plane(cube, plane->axis, plane->position); // Populate the cube with the new plane.
 
     // Reset flags.
-    timer   = 0;
-    looped  = 0;
-    loading = 0;
-  }
+    scene->state.plane_shift.looped = 0;
+    scene->state.plane_shift.loaded = 1;
 
-  // "tick" the timer.
-  timer++;
-
-  // "Wait" until timer reach defined count.
-  if (timer < 220) {
-    return;
+    // Display the new plane before moving it.
+    return PLANE_SHIFT_DELAY;
   }
 
-  // "Timer" triggered, step the plane.
-
-  timer = 0;                    // Reset the "timer".
-  shift(cube, plane.direction); // Shift the plane in selected direction.
+  // Step the plane.
+  shift(cube, plane->direction); // Shift the plane in selected direction.
 
   // Update plane and flags and check for edges, based on direction.
 
@@ -85,39 +69,41 @@ void                    plane_shift(cube_t cube) {
   // reverse direction, the second time, set the loading flag on
   // to re-init the scenario.
 
-  switch (plane.direction) {
+  switch (plane->direction) {
   case shiftPosX: case shiftPosY: case shiftPosZ:
     // When moving up, increment the position.
-    plane.position++;
+    plane->position++;
 
     // Going up, we check for the last edge.
-    if (plane.position == CUBE_SIZE - 1) {
-      if (!looped) {
+    if (plane->position == CUBE_SIZE - 1) {
+      if (!scene->state.plane_shift.looped) {
 	// 1st time we reach the edge, reverse direction.
-	plane.direction++; // The next enum from "pos" is "neg".
-	looped = 1;       // Flag that we reached an edge.
+	plane->direction++; // The next enum from "pos" is "neg".
+	scene->state.plane_shift.looped = 1; // Flag that we reached an edge.
       } else {
 	// 2nd time we reach the edge, flag for reset.
-	loading = 1;
+	scene->state.plane_shift.loaded = 0;
       }
     }
     break;
 
   case shiftNegX: case shiftNegY: case shiftNegZ:
     // When moving down, decrement the position.
-    plane.position--;
+    plane->position--;
 
     // Going down, we check for the first edge.
-    if (plane.position == 0) {
-      if (!looped) {
+    if (plane->position == 0) {
+      if (!scene->state.plane_shift.looped) {
 	// 1st time we reach the edge, reverse direction.
-	plane.direction--; // The previous enum from "neg" is "pos".
-	looped = 1;       // Flag that we reached an edge.
+	plane->direction--; // The previous enum from "neg" is "pos".
+	scene->state.plane_shift.looped = 1; // Flag that we reached an edge.
       } else {
 	// 2nd time we reach the edge, flag for reset.
-	loading = 1;
+	scene->state.plane_shift.loaded = 0;
       }
     }
     break;
   }
+
+  return PLANE_SHIFT_DELAY;
 }
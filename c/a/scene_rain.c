@@ -1,37 +1,27 @@
-#include <stdlib.h> // rand(3).
+#include "scenes.h" // scene_t, cube_t & co.
 
-#include "cube.h" // cube_t & co.
+// Delay in between steps (usec).
+#define RAIN_DELAY 60000
 
-// rain is a scene.
-void                    rain(cube_t cube) {
-  static char           loading = 1;
-  static unsigned int   timer   = 0;
-
-  // "tick" the timer.
-  timer++;
+// Density of the drops on the top layer, 2.25 drops per layer on average.
+// The rand_r(3) loop it replaced drew its bound again on each iteration, for 2.24.
+#define RAIN_DENSITY 9
 
+// rain is a scene.
+long    rain(scene_t* scene, cube_t cube) {
   // If loading, make sure to clear before we start.
-  if (loading) {
-    clearCube(cube);
-    loading = 0;
-  }
-
-  // "Wait" until timer reach defined count.
-  if (timer < 220) {
-    return;
+  if (!scene->state.rain.loaded) {
+    clear_cube(cube);
+    scene->state.rain.loaded = 1;
+    return RAIN_DELAY;
   }
 
-  // "Timer" triggered, shift the drops one layer and
-  // generate new ones on the top layer.
-
-  timer = 0;              // Reset the "timer".
+  // Shift the drops one layer and generate new ones on the top layer.
   shift(cube, shiftNegY); // Shift layers down.
 
-  // From 0 to CUBE_SIZE (i.e. sqrt of surface) drops per layer.
-  for (unsigned int i = 0; i < rand() % CUBE_SIZE; i++) {
-    set_voxel(cube,
-	     rand() % CUBE_SIZE,  // Random X.
-	     CUBE_SIZE - 1,       // Always top layer for Y.
-	     rand() % CUBE_SIZE); // Random Z.
-  }
+  // Each voxel of the top layer is a drop with probability RAIN_DENSITY / RNG_DENSITY_ONE,
+  // written at once.
+  set_layer(cube, CUBE_SIZE - 1, rng_mask(&scene->rng, RAIN_DENSITY));
+
+  return RAIN_DELAY;
 }
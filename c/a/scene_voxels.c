@@ -0,0 +1,82 @@
+#include "scenes.h" // scene_t, cube_t & co.
+#include "voxset.h" // voxset_t & co.
+
+// Delay in between steps (usec).
+#define FILL_DELAY     20000
+#define DISSOLVE_DELAY 20000
+#define SPARKLE_DELAY  30000
+
+// Delay with the cube full or empty before starting over (usec).
+#define VOXELS_HOLD    1000000
+
+// Number of voxels on while sparkling.
+#define SPARKLE_COUNT  64
+
+// fill is a scene, turning on a random voxel off per step until the cube is full.
+long    fill(scene_t* scene, cube_t cube) {
+  int   i;
+
+  // If loading, or held full, start over from an empty cube.
+  if (!scene->state.voxels.loaded) {
+    clear_cube(cube);
+    voxset_init(&scene->state.voxels.set, cube);
+    scene->state.voxels.loaded = 1;
+    return FILL_DELAY;
+  }
+  if ((i = voxset_pick_clear(&scene->state.voxels.set, &scene->rng)) < 0) {
+    scene->state.voxels.loaded = 0;
+    return FILL_DELAY;
+  }
+  voxset_set(&scene->state.voxels.set, cube, i);
+
+  // Hold once full.
+  return scene->state.voxels.set.count == VOXSET_SIZE ? VOXELS_HOLD : FILL_DELAY;
+}
+
+// dissolve is a scene, turning off a random voxel on per step until the cube is empty.
+long    dissolve(scene_t* scene, cube_t cube) {
+  int   i;
+
+  // If loading, or held empty, start over from a full cube.
+  if (!scene->state.voxels.loaded) {
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      set_plane(cube, axisY, y);
+    }
+    voxset_init(&scene->state.voxels.set, cube);
+    scene->state.voxels.loaded = 1;
+    return VOXELS_HOLD;
+  }
+  if ((i = voxset_pick_set(&scene->state.voxels.set, &scene->rng)) < 0) {
+    scene->state.voxels.loaded = 0;
+    return DISSOLVE_DELAY;
+  }
+  voxset_clear(&scene->state.voxels.set, cube, i);
+
+  // Hold once empty.
+  return scene->state.voxels.set.count == 0 ? VOXELS_HOLD : DISSOLVE_DELAY;
+}
+
+// sparkle is a scene, moving a random voxel on to a random voxel off per step,
+// SPARKLE_COUNT voxels on.
+long    sparkle(scene_t* scene, cube_t cube) {
+  voxset_t*     set = &scene->state.voxels.set;
+  int           on;
+
+  // If loading, light the first voxels.
+  if (!scene->state.voxels.loaded) {
+    clear_cube(cube);
+    voxset_init(set, cube);
+    for (int n = 0; n < SPARKLE_COUNT; n++) {
+      voxset_set(set, cube, voxset_pick_clear(set, &scene->rng));
+    }
+    scene->state.voxels.loaded = 1;
+    return SPARKLE_DELAY;
+  }
+
+  // Pick the new one first, so it's not the one going off.
+  on = voxset_pick_clear(set, &scene->rng);
+
+  voxset_clear(set, cube, voxset_pick_set(set, &scene->rng));
+  voxset_set(set, cube, on);
+  return SPARKLE_DELAY;
+}
@@ -0,0 +1,20 @@
+#include <string.h> // memset(3).
+
+#include "scenes.h" // scene_t, gray_t & co.
+
+// Delay in between steps (usec).
+#define WAVE_DELAY 20000
+
+// wave is a grayscale scene: brightness waves going up the layers.
+long                    wave(scene_t* scene, gray_t gray) {
+  unsigned int          phase = ++scene->state.wave.phase; // Move the wave up.
+  unsigned int          t;
+
+  // Triangle wave of the height, one period over the cube.
+  for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+    t = (phase * 8 - y * (256 / CUBE_SIZE)) & 0xFF;
+    memset(gray[CUBE_SIZE - 1 - y], t < 128 ? t * 2 : (255 - t) * 2, sizeof(gray[0]));
+  }
+
+  return WAVE_DELAY;
+}
@@ -0,0 +1,24 @@
+#include <string.h> // strcmp(3).
+
+#include "scenes.h"
+
+// Scenes by name.
+const scene_desc        scenes_all[] = {
+  { "plane_shift", plane_shift },
+  { "rain",        rain },
+  { "manual",      manual },
+  { "fill",        fill },
+  { "dissolve",    dissolve },
+  { "sparkle",     sparkle },
+  { NULL,          NULL },
+};
+
+// scene_lookup returns the scene with the given name, NULL if unknown.
+const scene_desc*       scene_lookup(const char* name) {
+  for (const scene_desc* scene = scenes_all; scene->name; scene++) {
+    if (!strcmp(scene->name, name)) {
+      return scene;
+    }
+  }
+  return NULL;
+}
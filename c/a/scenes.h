@@ -2,9 +2,66 @@
 # define __SCENES_H__
 
 # include "cube.h" // cube_t.
+# include "gray.h"   // gray_t.
+# include "rng.h"    // rng_t.
+# include "voxset.h" // voxset_t.
 
-void plane_shift(cube_t);
-void rain(cube_t);
-void manual(cube_t);
+// Plane moving through the cube.
+typedef struct {
+    axis_t          axis;
+    shift_dir_t     direction;
+    int             position;
+}                   plane_t;
+
+// scene_t is the state of a scene instance, so several cubes or threads can run the
+// same scene. The state is zeroed before the first step, and the generator seeded.
+typedef struct {
+    rng_t                   rng; // Random generator, see rng_seed.
+    union {
+        struct {
+            char            loaded;
+            char            looped;
+            plane_t         plane;
+        }                   plane_shift;
+        struct {
+            char            loaded;
+        }                   rain;
+        struct {
+            int             step;
+            int             x;
+            int             y;
+            int             z;
+        }                   manual;
+        struct {
+            char            loaded;
+            voxset_t        set;
+        }                   voxels;
+        struct {
+            unsigned int    phase;
+        }                   wave;
+    }                       state;
+}                           scene_t;
+
+// Scenes step the cube and return the delay (usec) until their next step.
+long plane_shift(scene_t* scene, cube_t cube);
+long rain(scene_t* scene, cube_t cube);
+long manual(scene_t* scene, cube_t cube);
+long fill(scene_t* scene, cube_t cube);
+long dissolve(scene_t* scene, cube_t cube);
+long sparkle(scene_t* scene, cube_t cube);
+
+// Grayscale scenes.
+long wave(scene_t* scene, gray_t gray);
+
+// scene_desc names a scene.
+typedef struct {
+    const char*     name;
+    long            (*step)(scene_t* scene, cube_t cube);
+}                   scene_desc;
+
+// All the on/off scenes, NULL name terminated.
+extern const scene_desc scenes_all[];
+
+const scene_desc*       scene_lookup(const char* name);
 
 #endif /* !__SCENES_H__ */
@@ -0,0 +1,138 @@
+#define _DEFAULT_SOURCE     // For syscall(2) (fix warning on linux).
+#include <errno.h>          // errno(3).
+#include <limits.h>         // INT_MAX.
+#include <linux/futex.h>    // FUTEX_WAIT, FUTEX_WAKE.
+#include <string.h>         // memcpy(3), memcmp(3).
+#include <sys/mman.h>       // PROT_READ, PROT_WRITE.
+#include <sys/syscall.h>    // SYS_futex.
+#include <unistd.h>         // syscall(2).
+
+#include "shmfb.h"
+
+// layout maps the lanes and slots past the header.
+static void     layout(shmfb_t* fb) {
+  fb->header = fb->shm.map;
+  fb->lanes  = (shmfb_lane*)((char*)fb->shm.map + sizeof(shmfb_header));
+  fb->slots  = (shmfb_slot*)(fb->lanes + fb->header->units);
+}
+
+// shmfb_create creates, or replaces, the shared memory object with all slots cleared.
+// Returns -1 with errno set on failure.
+int             shmfb_create(shmfb_t* fb, const char* name, unsigned int units, unsigned int slots) {
+  size_t        size = sizeof(shmfb_header) + units * sizeof(shmfb_lane) + units * slots * sizeof(shmfb_slot);
+
+  memset(fb, 0, sizeof(*fb));
+  if (!units || slots < 2 || slots > SHMFB_MAX_SLOTS) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  // Writers of a previous object don't write in ours.
+  if (shmobj_create(&fb->shm, name, size, 0666) < 0) {
+    return -1;
+  }
+
+  fb->header             = fb->shm.map;
+  fb->header->version    = SHMFB_VERSION;
+  fb->header->frame_size = sizeof(cube_t);
+  fb->header->units      = units;
+  fb->header->slots      = slots;
+  layout(fb);
+
+  // Writers check the magic first.
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(fb->header->magic, SHMFB_MAGIC, sizeof(fb->header->magic));
+  return 0;
+}
+
+// shmfb_open maps an existing shared memory object and checks its layout.
+// Returns -1 with errno set on failure.
+int     shmfb_open(shmfb_t* fb, const char* name) {
+  memset(fb, 0, sizeof(*fb));
+  if (shmobj_open(&fb->shm, name, sizeof(shmfb_header), PROT_READ | PROT_WRITE) < 0) {
+    return -1;
+  }
+  fb->header = fb->shm.map;
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (memcmp(fb->header->magic, SHMFB_MAGIC, sizeof(fb->header->magic)) ||
+      fb->header->version != SHMFB_VERSION ||
+      fb->header->frame_size != sizeof(cube_t) ||
+      fb->header->slots < 2 || fb->header->slots > SHMFB_MAX_SLOTS ||
+      fb->shm.size != sizeof(shmfb_header) + fb->header->units * (sizeof(shmfb_lane) + fb->header->slots * sizeof(shmfb_slot))) {
+    shmfb_close(fb);
+    errno = EINVAL;
+    return -1;
+  }
+  layout(fb);
+  return 0;
+}
+
+// shmfb_close unmaps the framebuffer, and removes it if we created it.
+void    shmfb_close(shmfb_t* fb) {
+  shmobj_close(&fb->shm);
+}
+
+// shmfb_reader_init starts following the publications of the cube, from the next one.
+void    shmfb_reader_init(shmfb_reader* reader, shmfb_t* fb, unsigned int unit) {
+  memset(reader, 0, sizeof(*reader));
+  reader->lane  = &fb->lanes[unit];
+  reader->slots = shmfb_slot_at(fb, unit, 0);
+  reader->count = fb->header->slots;
+  reader->gen   = __atomic_load_n(&reader->lane->gen, __ATOMIC_ACQUIRE);
+}
+
+// shmfb_begin takes the slot after the newest one of the cube for writing.
+// Its frame holds an older frame, not necessarily the newest one.
+shmfb_slot*     shmfb_begin(shmfb_t* fb, unsigned int unit) {
+  shmfb_slot*   slot = shmfb_slot_at(fb, unit, (fb->lanes[unit].latest + 1) % fb->header->slots);
+
+  __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  return slot;
+}
+
+// shmfb_publish makes the slot the newest of the cube and wakes the sleeping readers, if any.
+void            shmfb_publish(shmfb_t* fb, unsigned int unit, shmfb_slot* slot) {
+  shmfb_lane*   lane = &fb->lanes[unit];
+
+  slot->stamp_ns = clock_now_ns();
+  __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&lane->latest, slot - shmfb_slot_at(fb, unit, 0), __ATOMIC_RELEASE);
+
+  // Sequentially consistent with shmfb_wait, so either the reader sees the new gen or we see it waiting.
+  __atomic_add_fetch(&lane->gen, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&lane->waiters, __ATOMIC_SEQ_CST)) {
+    syscall(SYS_futex, &lane->gen, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+  }
+}
+
+// shmfb_wait sleeps until the lane gen of the cube moves past gen, or the timeout.
+// Returns 0 once published, -1 with errno set on timeout (ETIMEDOUT) or signal (EINTR).
+int                     shmfb_wait(shmfb_t* fb, unsigned int unit, uint32_t gen, uint64_t timeout_ns) {
+  shmfb_lane*           lane    = &fb->lanes[unit];
+  struct timespec       timeout = {
+    .tv_sec  = timeout_ns / NSEC_PER_SEC,
+    .tv_nsec = timeout_ns % NSEC_PER_SEC,
+  };
+  int                   ret     = 0;
+
+  __atomic_add_fetch(&lane->waiters, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&lane->gen, __ATOMIC_SEQ_CST) == gen) {
+    ret = syscall(SYS_futex, &lane->gen, FUTEX_WAIT, gen, &timeout, NULL, 0);
+  }
+  __atomic_sub_fetch(&lane->waiters, 1, __ATOMIC_SEQ_CST);
+
+  // Woken up, or the gen moved before we slept.
+  if (ret < 0 && errno == EAGAIN) {
+    ret = 0;
+  }
+  return ret;
+}
+
+// shmfb_report prints the frames read and the publication to read latency.
+void    shmfb_report(const shmfb_reader* reader, const char* name, FILE* out) {
+  fprintf(out, "%s: %llu frames read, %llu torn\n",
+          name, (unsigned long long)reader->frames, (unsigned long long)reader->torn);
+  fprintf(out, "%s: publication to read latency min %.1f us, mean %.1f us, max %.1f us\n",
+          name, reader->min_ns / 1e3, reader->sum_ns / (reader->frames ? reader->frames : 1) / 1e3, reader->max_ns / 1e3);
+}
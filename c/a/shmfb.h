@@ -0,0 +1,142 @@
+#ifndef __SHMFB_H__
+# define __SHMFB_H__
+
+# include <stddef.h> // size_t.
+# include <stdint.h> // uint64_t & co.
+# include <stdio.h>  // FILE.
+
+# include "clock.h"  // clock_now_ns.
+# include "cube.h"   // cube_t.
+# include "shmobj.h" // shmobj_t.
+
+/**
+   Shared memory framebuffer, for external producers to drive the cubes without
+   a socket hop or a copy.
+
+   The renderer creates /dev/shm/<name>, producers map it and write their frames
+   straight in the slots. Layout, host byte order, all offsets 64 bytes aligned:
+
+   shmfb_header                  Magic "CUBESHM", version, frame size, cubes, slots per cube.
+   shmfb_lane[cubes]             Per cube: publication counter (futex word), waiters, newest slot.
+   shmfb_slot[cubes][slots]      Per slot: seqlock counter, publication time, cube_t frame.
+
+   There is a single writer per cube. To publish, it takes the slot after the newest
+   one, makes its seq odd, writes the frame, makes seq even again, then stores the
+   slot as newest and bumps the lane gen, waking the futex only if a reader sleeps.
+
+   Readers poll the lane gen, with a plain load when nothing changed, and read the
+   newest slot in place. They check the slot seq didn't move while reading, so a
+   frame overwritten meanwhile (the writer went around all the slots) gets dropped
+   and read again from the newest one.
+*/
+
+# define SHMFB_MAGIC     "CUBESHM"
+# define SHMFB_VERSION   1
+
+// Default and maximum number of slots per cube.
+# define SHMFB_SLOTS     4
+# define SHMFB_MAX_SLOTS 64
+
+typedef struct {
+    char            magic[8];   // SHMFB_MAGIC, set last by the creator.
+    uint32_t        version;    // SHMFB_VERSION.
+    uint32_t        frame_size; // sizeof(cube_t).
+    uint32_t        units;      // Number of cubes.
+    uint32_t        slots;      // Number of slots per cube.
+    uint8_t         reserved[40];
+}                   shmfb_header;
+
+typedef struct {
+    uint32_t        gen;        // Bumped on each publication, futex word.
+    uint32_t        waiters;    // Number of readers sleeping on gen.
+    uint32_t        latest;     // Newest published slot.
+    uint8_t         reserved[52];
+}                   shmfb_lane;
+
+typedef struct {
+    uint32_t        seq;        // Seqlock, odd while the frame is written.
+    uint32_t        reserved;
+    uint64_t        stamp_ns;   // Monotonic time of the publication.
+    uint8_t         pad[48];
+    cube_t          frame;
+}                   shmfb_slot;
+
+typedef struct {
+    shmobj_t        shm;
+    shmfb_header*   header;
+    shmfb_lane*     lanes;
+    shmfb_slot*     slots;
+}                   shmfb_t;
+
+// shmfb_reader follows the publications of a cube.
+typedef struct {
+    shmfb_lane*     lane;
+    shmfb_slot*     slots;
+    uint32_t        count;      // Number of slots.
+    uint32_t        gen;        // Lane gen of the last frame read.
+    uint32_t        seq;        // Slot seq of the frame being read.
+
+    uint64_t        frames;     // Frames read.
+    uint64_t        torn;       // Frames overwritten while read.
+    uint64_t        min_ns;     // Minimum publication to read latency.
+    uint64_t        max_ns;     // Maximum publication to read latency.
+    uint64_t        sum_ns;     // Sum of the publication to read latencies.
+}                   shmfb_reader;
+
+// shmfb_slot_at returns the ith slot of the cube.
+# define shmfb_slot_at(fb, unit, i) (&(fb)->slots[(unit) * (fb)->header->slots + (i)])
+
+// shmfb_poll returns the newest slot of the cube if published since the last frame read,
+// NULL otherwise. Only does a load when nothing changed.
+static inline shmfb_slot*       shmfb_poll(shmfb_reader* reader) {
+  uint32_t                      gen = __atomic_load_n(&reader->lane->gen, __ATOMIC_ACQUIRE);
+  shmfb_slot*                   slot;
+
+  if (gen == reader->gen) {
+    return NULL;
+  }
+  slot        = &reader->slots[__atomic_load_n(&reader->lane->latest, __ATOMIC_ACQUIRE) % reader->count];
+  reader->seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+  if (reader->seq & 1) {
+    // Already being overwritten, try again on the next poll.
+    reader->torn++;
+    return NULL;
+  }
+  reader->gen = gen;
+  return slot;
+}
+
+// shmfb_check tells if the frame of the slot polled was read whole.
+// If not, the next poll returns the newest slot again.
+static inline int       shmfb_check(shmfb_reader* reader, const shmfb_slot* slot) {
+  uint64_t              latency;
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != reader->seq) {
+    reader->gen--;
+    reader->torn++;
+    return 0;
+  }
+
+  latency = clock_now_ns() - slot->stamp_ns;
+  if (!reader->frames || latency < reader->min_ns) {
+    reader->min_ns = latency;
+  }
+  if (latency > reader->max_ns) {
+    reader->max_ns = latency;
+  }
+  reader->sum_ns += latency;
+  reader->frames++;
+  return 1;
+}
+
+int             shmfb_create(shmfb_t* fb, const char* name, unsigned int units, unsigned int slots);
+int             shmfb_open(shmfb_t* fb, const char* name);
+void            shmfb_close(shmfb_t* fb);
+void            shmfb_reader_init(shmfb_reader* reader, shmfb_t* fb, unsigned int unit);
+shmfb_slot*     shmfb_begin(shmfb_t* fb, unsigned int unit);
+void            shmfb_publish(shmfb_t* fb, unsigned int unit, shmfb_slot* slot);
+int             shmfb_wait(shmfb_t* fb, unsigned int unit, uint32_t gen, uint64_t timeout_ns);
+void            shmfb_report(const shmfb_reader* reader, const char* name, FILE* out);
+
+#endif /* !__SHMFB_H__ */
@@ -0,0 +1,96 @@
+#define _DEFAULT_SOURCE     // For MAP_POPULATE (fix warning on linux).
+#include <errno.h>          // errno(3).
+#include <fcntl.h>          // O_* constants.
+#include <string.h>         // memset(3), strlen(3), strcpy(3).
+#include <sys/mman.h>       // shm_open(3), mmap(2).
+#include <sys/stat.h>       // fstat(2).
+#include <unistd.h>         // ftruncate(2), close(2).
+
+#include "shmobj.h"
+
+// set_name stores the shared memory object name, with the leading slash shm_open(3) expects.
+// Returns -1 with errno set on failure.
+static int      set_name(shmobj_t* obj, const char* name) {
+  if (strlen(name) + 2 > sizeof(obj->name)) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  obj->name[0] = '/';
+  strcpy(obj->name + (name[0] != '/'), name);
+  return 0;
+}
+
+// map maps the shared memory object of the given size, and closes fd.
+// Returns -1 with errno set on failure.
+static int      map(shmobj_t* obj, int fd, size_t size, int prot) {
+  obj->size = size;
+  obj->map  = mmap(NULL, size, prot, MAP_SHARED | MAP_POPULATE, fd, 0);
+  close(fd);
+  if (obj->map == MAP_FAILED) {
+    obj->map = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+// shmobj_create creates, or replaces, the shared memory object, zeroed and mapped read write.
+// Returns -1 with errno set on failure.
+int     shmobj_create(shmobj_t* obj, const char* name, size_t size, mode_t mode) {
+  int   fd;
+
+  memset(obj, 0, sizeof(*obj));
+  if (set_name(obj, name) < 0) {
+    return -1;
+  }
+
+  // Start from a zeroed object, so the users of a previous one don't share ours.
+  shm_unlink(obj->name);
+  if ((fd = shm_open(obj->name, O_RDWR | O_CREAT | O_EXCL, mode)) < 0) {
+    return -1;
+  }
+  obj->owner = 1;
+  if (ftruncate(fd, size) < 0) {
+    close(fd);
+    shmobj_close(obj);
+    return -1;
+  }
+  if (map(obj, fd, size, PROT_READ | PROT_WRITE) < 0) {
+    shmobj_close(obj);
+    return -1;
+  }
+  return 0;
+}
+
+// shmobj_open maps an existing shared memory object whole, read only unless prot has PROT_WRITE.
+// Returns -1 with errno set on failure, EINVAL when smaller than min_size.
+int             shmobj_open(shmobj_t* obj, const char* name, size_t min_size, int prot) {
+  struct stat   st;
+  int           fd;
+
+  memset(obj, 0, sizeof(*obj));
+  if (set_name(obj, name) < 0 || (fd = shm_open(obj->name, prot & PROT_WRITE ? O_RDWR : O_RDONLY, 0)) < 0) {
+    return -1;
+  }
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return -1;
+  }
+  if ((size_t)st.st_size < min_size) {
+    close(fd);
+    errno = EINVAL;
+    return -1;
+  }
+  return map(obj, fd, st.st_size, prot);
+}
+
+// shmobj_close unmaps the shared memory object, and removes it if we created it.
+void    shmobj_close(shmobj_t* obj) {
+  if (obj->map) {
+    munmap(obj->map, obj->size);
+    obj->map = NULL;
+  }
+  if (obj->owner) {
+    shm_unlink(obj->name);
+    obj->owner = 0;
+  }
+}
@@ -0,0 +1,25 @@
+#ifndef __SHMOBJ_H__
+# define __SHMOBJ_H__
+
+# include <stddef.h>    // size_t.
+# include <sys/types.h> // mode_t.
+
+/**
+   Shared memory object mapping, under /dev/shm, for shmfb and stats.
+
+   The creator replaces any previous object of the name, so the users of the
+   previous one see it go, and removes it on close. The others map it as is.
+*/
+
+typedef struct {
+    void*           map;
+    size_t          size;
+    char            name[64];   // Shared memory object, "/name", removed on close by its creator.
+    int             owner;
+}                   shmobj_t;
+
+int     shmobj_create(shmobj_t* obj, const char* name, size_t size, mode_t mode);
+int     shmobj_open(shmobj_t* obj, const char* name, size_t min_size, int prot);
+void    shmobj_close(shmobj_t* obj);
+
+#endif /* !__SHMOBJ_H__ */
@@ -0,0 +1,200 @@
+#define _DEFAULT_SOURCE // For getopt(3) (fix warning on linux).
+#include <errno.h>      // errno(3).
+#include <pthread.h>    // pthread_create(3).
+#include <signal.h>     // signal(2).
+#include <stdio.h>      // fprintf(3), perror(3).
+#include <stdlib.h>     // strtoul(3), strtoull(3).
+#include <string.h>     // memset(3), memcpy(3), strerror(3).
+#include <time.h>       // time(2) (for random seeds).
+#include <unistd.h>     // getopt(3).
+
+#include "clock.h"      // Monotonic clock.
+#include "cube.h"       // Cube managment.
+#include "kernels.h"    // Cube kernels.
+#include "scenes.h"     // Scenes.
+#include "shmfb.h"      // Shared memory framebuffer.
+
+/**
+   shmwrite is the reference writer of the shared memory framebuffer: it runs a
+   scene and publishes its frames to a cube started with -m.
+
+   Frames are published as the scene changes them, or at a fixed rate with -r.
+
+   With -b, it benchmarks the framebuffer on its own instead: it creates it, and
+   measures the raw publish throughput, then the publication to read latency of a
+   reader thread sleeping on the futex, as the scene frames get published at the rate.
+*/
+
+// Number of frames published by the throughput benchmark.
+#define BENCH_FRAMES 10000000
+
+static volatile int _running = 1;
+
+static void intHandler() {
+    _running = 0;
+}
+
+static void     usage(const char* name) {
+  fprintf(stderr, "usage: %s [-b] [-r rate] [-n frames] [-u cube] [-s seed] name scene\n", name);
+  fprintf(stderr, "  -b            Benchmark a framebuffer of our own instead of writing to a cube.\n");
+  fprintf(stderr, "  -r rate       Publish the current frame at rate Hz (default: when the scene changes it).\n");
+  fprintf(stderr, "  -n frames     Stop after publishing frames (default: on SIGINT).\n");
+  fprintf(stderr, "  -u cube       Index of the cube to write to (default 0).\n");
+  fprintf(stderr, "  -s seed       Seed of the scene (default: time).\n");
+}
+
+// reader is the benchmark reader thread, sleeping until each publication.
+static void*    reader(void* arg) {
+  shmfb_t*      fb = arg;
+  shmfb_reader  r;
+  shmfb_slot*   slot;
+  cube_t        cube;
+
+  shmfb_reader_init(&r, fb, 0);
+  while (_running) {
+    if (shmfb_wait(fb, 0, r.gen, NSEC_PER_SEC / 10) < 0 && errno != ETIMEDOUT && errno != EINTR) {
+      perror("futex");
+      break;
+    }
+    while ((slot = shmfb_poll(&r))) {
+      memcpy(cube, slot->frame, sizeof(cube));
+      if (shmfb_check(&r, slot)) {
+        break;
+      }
+    }
+  }
+  shmfb_report(&r, "shmwrite reader", stderr);
+  return NULL;
+}
+
+// bench_throughput publishes frames back to back, without any reader.
+static void             bench_throughput(shmfb_t* fb, cube_t cube) {
+  uint64_t              start = clock_now_ns();
+  uint64_t              elapsed;
+  shmfb_slot*           slot;
+
+  for (unsigned int i = 0; i < BENCH_FRAMES; i++) {
+    slot = shmfb_begin(fb, 0);
+    memcpy(slot->frame, cube, sizeof(cube_t));
+    shmfb_publish(fb, 0, slot);
+  }
+  elapsed = clock_now_ns() - start;
+  fprintf(stderr, "shmwrite: %u frames published in %.3f s, %.1f ns per frame, %.1f M frames/s\n",
+          BENCH_FRAMES, elapsed / 1e9, (double)elapsed / BENCH_FRAMES, BENCH_FRAMES * 1e3 / elapsed);
+}
+
+int                     main(int argc, char** argv) {
+  const scene_desc*     desc;
+  scene_t               scene;
+  cube_t                cube;
+  shmfb_t               fb;
+  shmfb_slot*           slot;
+  pthread_t             thread;
+  uint64_t              rate   = 0;
+  uint64_t              frames = UINT64_MAX;
+  uint64_t              sent   = 0;
+  unsigned int          unit   = 0;
+  int                   bench  = 0;
+  uint64_t              start;
+  uint64_t              now;
+  uint64_t              next_step;
+  uint64_t              next_send;
+  unsigned long         generation;
+  int                   opt;
+  int                   ret;
+
+  memset(&scene, 0, sizeof(scene));
+  rng_seed(&scene.rng, time(NULL));
+
+  while ((opt = getopt(argc, argv, "br:n:u:s:")) != -1) {
+    switch (opt) {
+    case 'b':
+      bench = 1;
+      break;
+    case 'r':
+      rate = strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      frames = strtoul(optarg, NULL, 10);
+      break;
+    case 'u':
+      unit = strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      rng_seed(&scene.rng, strtoull(optarg, NULL, 10));
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (argc - optind != 2 || !(desc = scene_lookup(argv[optind + 1]))) {
+    usage(argv[0]);
+    return 1;
+  }
+  if ((bench ? shmfb_create(&fb, argv[optind], 1, SHMFB_SLOTS) : shmfb_open(&fb, argv[optind])) < 0) {
+    perror(argv[optind]);
+    return 1;
+  }
+  if (unit >= fb.header->units) {
+    fprintf(stderr, "%s: no cube %u\n", argv[optind], unit);
+    shmfb_close(&fb);
+    return 1;
+  }
+
+  signal(SIGINT, intHandler);
+  signal(SIGTERM, intHandler);
+
+  cube_kernels_init(NULL);
+  clear_cube(cube);
+
+  if (bench) {
+    bench_throughput(&fb, cube);
+    if ((ret = pthread_create(&thread, NULL, reader, &fb))) {
+      fprintf(stderr, "error starting the reader: %s\n", strerror(ret));
+      shmfb_close(&fb);
+      return 1;
+    }
+  }
+
+  start     = clock_now_ns();
+  next_step = start;
+  next_send = UINT64_MAX;
+  while (_running && sent < frames) {
+    // Step the scene when due, publishing the changed frames unless publishing at a fixed rate.
+    now = clock_now_ns();
+    if (now >= next_step) {
+      generation = cube_generation();
+      next_step += desc->step(&scene, cube) * 1000;
+      if (next_step < now) {
+        next_step = now;
+      }
+      if (!rate && cube_generation() != generation) {
+        next_send = now;
+      }
+    }
+    if (rate && next_send == UINT64_MAX) {
+      next_send = start;
+    }
+
+    if (now >= next_send) {
+      slot = shmfb_begin(&fb, unit);
+      memcpy(slot->frame, cube, sizeof(cube_t));
+      shmfb_publish(&fb, unit, slot);
+      sent++;
+      next_send = rate ? next_send + NSEC_PER_SEC / rate : UINT64_MAX;
+    }
+
+    clock_sleep_until(next_step < next_send ? next_step : next_send);
+  }
+
+  now = clock_now_ns();
+  fprintf(stderr, "shmwrite: %llu frames published in %.3f s (%.0f Hz)\n",
+          (unsigned long long)sent, (now - start) / 1e9, sent * 1e9 / (now - start));
+  if (bench) {
+    _running = 0;
+    pthread_join(thread, NULL);
+  }
+  shmfb_close(&fb);
+  return 0;
+}
@@ -1,13 +1,80 @@
+#define _DEFAULT_SOURCE // For clock_nanosleep(2) (fix warning on linux).
+#include <errno.h>     // errno(3).
 #include <fcntl.h>     // open(2).
-#include <unistd.h>    // close(3).
+#include <string.h>    // memset(3), strcmp(3).
+#include <unistd.h>    // close(3), write(2).
 #include <sys/ioctl.h> // ioctl(2).
 
 #include <linux/spi/spidev.h> // spi_ioc_transfer & ioctls consts.
 
 #include "spi.h"
+#include "spi_sim.h"   // spi_sim_transport.
+#include "clock.h"     // clock_now_ns, clock_sleep_until.
+
+// Known transports, looked up by name.
+static const spi_transport*     transports[] = {
+  &spi_spidev_transport,
+  &spi_spidev_wo_transport,
+  &spi_write_transport,
+  &spi_gpio_transport,
+  &spi_file_transport,
+  &spi_sim_transport,
+};
+
+// spi_transport_lookup returns the transport with the given name, NULL if unknown.
+const spi_transport*    spi_transport_lookup(const char* name) {
+  for (unsigned int i = 0; i < sizeof(transports) / sizeof(transports[0]); i++) {
+    if (!strcmp(transports[i]->name, name)) {
+      return transports[i];
+    }
+  }
+  return NULL;
+}
+
+// transport returns the handler's transport, defaulting to spidev.
+static inline const spi_transport*      transport(const spi_handler* hdlr) {
+  return hdlr->transport ? hdlr->transport : &spi_spidev_transport;
+}
 
 // spi_transfer uses SPI to send tx and receive rx. tx and rx must be allocated with len size.
-int                             spi_transfer(const spi_handler* hdlr, const void* tx, void* rx, int len) {
+int     spi_transfer(const spi_handler* hdlr, const void* tx, void* rx, int len) {
+  return transport(hdlr)->transfer(hdlr, tx, rx, len);
+}
+
+// spi_transfer_frame uses SPI to send count words of len bytes each, stored contiguously in tx,
+// as a single message. The chip select is released in between each word so the shift registers
+// latch them one at a time, with the configured delay as hold time.
+int     spi_transfer_frame(const spi_handler* hdlr, const void* tx, int len, int count) {
+  return spi_transfer_frame_hold(hdlr, tx, len, count, NULL);
+}
+
+// spi_transfer_frame_hold is spi_transfer_frame with a hold time (usec) per word instead of the configured delay.
+// Word i stays latched for holds[i] plus the wire time of the next word. spidev and spidev-wo wait the
+// delay of a transfer before releasing the chip select, so they put the hold of each word on the next
+// transfer, see spi_latch_delay. write and gpio latch each word first, then hold it. The sim transport
+// models spidev unless spi_sim_latch_first is set. The hold of the last word only holds as long as the
+// next message follows right away, a trailing blank word with no hold keeps the frame exact.
+int     spi_transfer_frame_hold(const spi_handler* hdlr, const void* tx, int len, int count, const uint16_t* holds) {
+  if (count < 1 || count > SPI_FRAME_MAX_WORDS) {
+    errno = EINVAL;
+    return -1;
+  }
+  return transport(hdlr)->transfer_frame(hdlr, tx, len, count, holds);
+}
+
+// spi_setup initializes the SPI with the hdlr->config values.
+int     spi_setup(spi_handler* hdlr) {
+  return transport(hdlr)->setup(hdlr);
+}
+
+// spi_cleanup closes down the SPI.
+int     spi_cleanup(spi_handler* hdlr) {
+  return transport(hdlr)->cleanup(hdlr);
+}
+
+// spidev transport.
+
+static int                      spidev_transfer(const spi_handler* hdlr, const void* tx, void* rx, int len) {
   struct spi_ioc_transfer       tr = {
     .tx_buf        = (unsigned long)tx,
     .rx_buf        = (unsigned long)rx,
@@ -20,14 +87,29 @@ int                             spi_transfer(const spi_handler* hdlr, const void
   return ioctl(hdlr->fd, SPI_IOC_MESSAGE(1), &tr);
 }
 
-// spi_setup initializes the SPI with the hdlr->config values.
-int     spi_setup(spi_handler* hdlr) {
-  int   ret;
+static int                      spidev_transfer_frame(const spi_handler* hdlr, const void* tx, int len, int count, const uint16_t* holds) {
+  struct spi_ioc_transfer       tr[SPI_FRAME_MAX_WORDS];
+  const unsigned char*          word = tx;
 
-  // TODO: Check if it would work in WR_ONLY, skipping all the RD iotctls and NULL the tx rd.
+  memset(tr, 0, sizeof(*tr) * count);
+  for (int i = 0; i < count; i++, word += len) {
+    tr[i].tx_buf        = (unsigned long)word;
+    tr[i].len           = len;
+    tr[i].speed_hz      = hdlr->config.speed;
+    tr[i].delay_usecs   = spi_latch_delay(&hdlr->config, holds, i, count);
+    tr[i].bits_per_word = hdlr->config.bits;
+    tr[i].cs_change     = i < count - 1; // Latch in between words, the last one is released by the driver.
+  }
+
+  return ioctl(hdlr->fd, SPI_IOC_MESSAGE(count), tr);
+}
+
+// spidev_open opens the device and sets the SPI config, reading it back unless write only.
+static int      spidev_open(spi_handler* hdlr, int write_only) {
+  int           ret;
 
-  // Open the device in read/write.
-  if ((ret = open(hdlr->config.device, O_RDWR))  < 0) {
+  // Open the device.
+  if ((ret = open(hdlr->config.device, write_only ? O_WRONLY : O_RDWR))  < 0) {
     return ret;
   }
   hdlr->fd = ret;
@@ -36,7 +118,7 @@ int     spi_setup(spi_handler* hdlr) {
   if ((ret = ioctl(hdlr->fd, SPI_IOC_WR_MODE, &hdlr->config.mode)) < 0) {
     return ret;
   }
-  if ((ret = ioctl(hdlr->fd, SPI_IOC_RD_MODE, &hdlr->config.mode)) < 0) {
+  if (!write_only && (ret = ioctl(hdlr->fd, SPI_IOC_RD_MODE, &hdlr->config.mode)) < 0) {
     return ret;
   }
 
@@ -44,7 +126,7 @@ int     spi_setup(spi_handler* hdlr) {
   if ((ret = ioctl(hdlr->fd, SPI_IOC_WR_BITS_PER_WORD, &hdlr->config.bits)) < 0) {
     return ret;
   }
-  if ((ret = ioctl(hdlr->fd, SPI_IOC_RD_BITS_PER_WORD, &hdlr->config.bits)) < 0) {
+  if (!write_only && (ret = ioctl(hdlr->fd, SPI_IOC_RD_BITS_PER_WORD, &hdlr->config.bits)) < 0) {
     return ret;
   }
 
@@ -52,7 +134,7 @@ int     spi_setup(spi_handler* hdlr) {
   if ((ret = ioctl(hdlr->fd, SPI_IOC_WR_MAX_SPEED_HZ, &hdlr->config.speed)) < 0) {
     return ret;
   }
-  if ((ret = ioctl(hdlr->fd, SPI_IOC_RD_MAX_SPEED_HZ, &hdlr->config.speed)) < 0) {
+  if (!write_only && (ret = ioctl(hdlr->fd, SPI_IOC_RD_MAX_SPEED_HZ, &hdlr->config.speed)) < 0) {
     return ret;
   }
 
@@ -60,9 +142,12 @@ int     spi_setup(spi_handler* hdlr) {
   return 0;
 }
 
-// spi_cleanup closes down the SPI.
-int     spi_cleanup(spi_handler* hdlr) {
-  int   ret;
+static int      spidev_setup(spi_handler* hdlr) {
+  return spidev_open(hdlr, 0);
+}
+
+static int      spidev_cleanup(spi_handler* hdlr) {
+  int           ret;
 
   if ((ret = close(hdlr->fd)) < 0) {
     return ret;
@@ -71,3 +156,87 @@ int     spi_cleanup(spi_handler* hdlr) {
 
   return 0;
 }
+
+// spi_spidev_transport talks to the kernel spidev driver, e.g. /dev/spidev0.0.
+// The driver runs delay_usecs then releases the chip select: each transfer holds the previous word, then latches.
+const spi_transport     spi_spidev_transport = {
+  .name           = "spidev",
+  .setup          = spidev_setup,
+  .cleanup        = spidev_cleanup,
+  .transfer       = spidev_transfer,
+  .transfer_frame = spidev_transfer_frame,
+};
+
+// spidev write only transport.
+
+static int                      spidev_wo_transfer(const spi_handler* hdlr, const void* tx, void* rx, int len) {
+  struct spi_ioc_transfer       tr = {
+    .tx_buf        = (unsigned long)tx,
+    .len           = len,
+    .speed_hz      = hdlr->config.speed,
+    .delay_usecs   = hdlr->config.delay,
+    .bits_per_word = hdlr->config.bits,
+  };
+
+  (void)rx;
+  return ioctl(hdlr->fd, SPI_IOC_MESSAGE(1), &tr);
+}
+
+static int      spidev_wo_setup(spi_handler* hdlr) {
+  return spidev_open(hdlr, 1);
+}
+
+// spi_spidev_wo_transport is spidev, half-duplex: the device is opened write only, the config
+// isn't read back and nothing is received, rx is left untouched.
+const spi_transport     spi_spidev_wo_transport = {
+  .name           = "spidev-wo",
+  .setup          = spidev_wo_setup,
+  .cleanup        = spidev_cleanup,
+  .transfer       = spidev_wo_transfer,
+  .transfer_frame = spidev_transfer_frame,
+};
+
+// write(2) transport.
+
+// write_word sends a word with write(2), as a transfer of its own.
+static int      write_word(const spi_handler* hdlr, const void* tx, int len) {
+  int           ret;
+
+  while ((ret = write(hdlr->fd, tx, len)) < 0 && errno == EINTR);
+  return ret;
+}
+
+static int      write_transfer(const spi_handler* hdlr, const void* tx, void* rx, int len) {
+  (void)rx;
+  return write_word(hdlr, tx, len);
+}
+
+static int              write_transfer_frame(const spi_handler* hdlr, const void* tx, int len, int count, const uint16_t* holds) {
+  const unsigned char*  word = tx;
+  unsigned int          hold;
+  int                   ret;
+
+  for (int i = 0; i < count; i++, word += len) {
+    if ((ret = write_word(hdlr, word, len)) < 0) {
+      return ret;
+    }
+
+    // The driver releases the chip select after each write, the word is latched.
+    if ((hold = holds ? holds[i] : hdlr->config.delay)) {
+      while (clock_sleep_until(clock_now_ns() + hold * 1000ULL) == EINTR);
+    }
+  }
+
+  return len * count;
+}
+
+// spi_write_transport sends each word with a plain write(2) on the spidev device, at the
+// configured speed and bits. It saves building the transfers, but costs a syscall per word,
+// and the hold time is slept in user space, after the word is latched.
+const spi_transport     spi_write_transport = {
+  .name           = "write",
+  .setup          = spidev_wo_setup,
+  .cleanup        = spidev_cleanup,
+  .transfer       = write_transfer,
+  .transfer_frame = write_transfer_frame,
+};
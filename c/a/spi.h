@@ -14,9 +14,13 @@
        .speed  = 8000000,          // 8 MHz.
        .delay  = 5,                // 5 usec delay.
      },
+     .transport = NULL,            // Defaults to spidev, see spi_transport_lookup.
    };
 */
 
+// Maximum number of words in a single spi_transfer_frame message.
+# define SPI_FRAME_MAX_WORDS 64
+
 typedef struct {
     const char* device; // Device path.
     uint8_t     mode;   // SPI mode.
@@ -25,13 +29,45 @@ typedef struct {
     uint16_t    delay;  // Delay between words (usec).
 }               spi_config;
 
+typedef struct spi_handler spi_handler;
+
+// spi_transport is the backend driving a handler.
+// Each operation follows the semantics of the matching spi_* function, but for the order of the
+// hold and the latch of each word, which follows the hardware, see spi_transfer_frame_hold.
 typedef struct {
-    spi_config  config;
-    int         fd;
-}               spi_handler;
+    const char* name;
+    int         (*setup)(spi_handler* hdlr);
+    int         (*cleanup)(spi_handler* hdlr);
+    int         (*transfer)(const spi_handler* hdlr, const void* tx, void* rx, int len);
+    int         (*transfer_frame)(const spi_handler* hdlr, const void* tx, int len, int count, const uint16_t* holds);
+}               spi_transport;
+
+struct spi_handler {
+    spi_config              config;
+    const spi_transport*    transport; // NULL means spidev.
+    void*                   priv;      // Transport private state.
+    int                     fd;
+};
+
+extern const spi_transport spi_spidev_transport;
+extern const spi_transport spi_spidev_wo_transport;
+extern const spi_transport spi_write_transport;
+extern const spi_transport spi_gpio_transport;
+extern const spi_transport spi_file_transport;
+
+const spi_transport*    spi_transport_lookup(const char* name);
+
+// spi_latch_delay returns the delay (usec) to run before latching the ith of count words, for the
+// transports holding before the latch: the hold of the word before it, so word i stays latched for
+// holds[i]. The last word stays latched until the next message, it gives its hold to the first one.
+static inline unsigned int      spi_latch_delay(const spi_config* config, const uint16_t* holds, int i, int count) {
+  return holds ? holds[(i + count - 1) % count] : config->delay;
+}
 
 int     spi_setup(spi_handler* hdlr);
 int     spi_cleanup(spi_handler* hdlr);
 int     spi_transfer(const spi_handler* hdlr, const void* tx, void* rx, int len);
+int     spi_transfer_frame(const spi_handler* hdlr, const void* tx, int len, int count);
+int     spi_transfer_frame_hold(const spi_handler* hdlr, const void* tx, int len, int count, const uint16_t* holds);
 
 #endif /* !__SPI_H__ */
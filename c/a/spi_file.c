@@ -0,0 +1,60 @@
+#include <errno.h>          // errno(3).
+#include <fcntl.h>          // open(2).
+#include <unistd.h>         // write(2), close(2).
+
+#include "spi.h"
+
+// write_all writes the whole buffer, across short writes.
+static int      write_all(int fd, const void* buf, int len) {
+  const char*   p = buf;
+  int           ret;
+
+  for (int done = 0; done < len; done += ret) {
+    if ((ret = write(fd, p + done, len - done)) < 0) {
+      if (errno == EINTR) {
+        ret = 0;
+        continue;
+      }
+      return -1;
+    }
+  }
+  return len;
+}
+
+static int      file_transfer(const spi_handler* hdlr, const void* tx, void* rx, int len) {
+  (void)rx;
+  return write_all(hdlr->fd, tx, len);
+}
+
+static int      file_transfer_frame(const spi_handler* hdlr, const void* tx, int len, int count, const uint16_t* holds) {
+  (void)holds;
+  return write_all(hdlr->fd, tx, len * count);
+}
+
+static int      file_setup(spi_handler* hdlr) {
+  if ((hdlr->fd = open(hdlr->config.device, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+static int      file_cleanup(spi_handler* hdlr) {
+  int           ret;
+
+  if ((ret = close(hdlr->fd)) < 0) {
+    return ret;
+  }
+  hdlr->fd = -1;
+  return 0;
+}
+
+// spi_file_transport writes the raw words sent to a file or a pipe, a frame per write(2),
+// to record them or hand them to another process. Holds are not kept, and opening a FIFO
+// blocks until its reader opens it.
+const spi_transport     spi_file_transport = {
+  .name           = "file",
+  .setup          = file_setup,
+  .cleanup        = file_cleanup,
+  .transfer       = file_transfer,
+  .transfer_frame = file_transfer_frame,
+};
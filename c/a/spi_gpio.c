@@ -0,0 +1,140 @@
+#define _DEFAULT_SOURCE     // For clock_nanosleep(2) (fix warning on linux).
+#include <errno.h>          // errno(3).
+#include <fcntl.h>          // open(2).
+#include <stdio.h>          // sscanf(3).
+#include <stdlib.h>         // calloc(3), free(3).
+#include <string.h>         // memset(3), strchr(3), strncpy(3).
+#include <sys/ioctl.h>      // ioctl(2).
+#include <unistd.h>         // close(2).
+
+#include <linux/gpio.h>     // GPIO v2 character device ioctls.
+
+#include "spi.h"
+#include "clock.h"          // clock_now_ns, clock_sleep_until.
+
+// Lines of the request, in this order.
+enum {
+  lineClock, // 74HC595 SRCLK, shifts on the rising edge.
+  lineData,  // 74HC595 SER.
+  lineLatch, // 74HC595 RCLK, latches on the rising edge.
+  lineCount,
+};
+
+typedef struct {
+  int           fd; // Line request.
+}               gpio_t;
+
+// set_lines drives the lines of the mask to the given values.
+static inline int               set_lines(const gpio_t* gpio, uint64_t mask, uint64_t bits) {
+  struct gpio_v2_line_values    values = { .bits = bits, .mask = mask };
+
+  return ioctl(gpio->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values);
+}
+
+// shift_word bit-bangs the word MSB first, as SPI mode 0, then latches it.
+static int              shift_word(const gpio_t* gpio, const uint8_t* word, int len) {
+  uint64_t              data;
+
+  if (set_lines(gpio, 1 << lineLatch, 0) < 0) {
+    return -1;
+  }
+  for (int i = 0; i < len; i++) {
+    for (int b = 7; b >= 0; b--) {
+      // Clock low with the data bit, then the rising edge shifts it in.
+      data = ((word[i] >> b) & 1) << lineData;
+      if (set_lines(gpio, (1 << lineClock) | (1 << lineData), data) < 0 ||
+          set_lines(gpio, 1 << lineClock, 1 << lineClock) < 0) {
+        return -1;
+      }
+    }
+  }
+  return set_lines(gpio, (1 << lineClock) | (1 << lineLatch), 1 << lineLatch);
+}
+
+static int      gpio_transfer(const spi_handler* hdlr, const void* tx, void* rx, int len) {
+  (void)rx;
+  if (shift_word(hdlr->priv, tx, len) < 0) {
+    return -1;
+  }
+  return len;
+}
+
+static int              gpio_transfer_frame(const spi_handler* hdlr, const void* tx, int len, int count, const uint16_t* holds) {
+  const uint8_t*        word = tx;
+  unsigned int          hold;
+
+  for (int i = 0; i < count; i++, word += len) {
+    if (shift_word(hdlr->priv, word, len) < 0) {
+      return -1;
+    }
+    if ((hold = holds ? holds[i] : hdlr->config.delay)) {
+      while (clock_sleep_until(clock_now_ns() + hold * 1000ULL) == EINTR);
+    }
+  }
+  return len * count;
+}
+
+// gpio_setup parses "/dev/gpiochipN:clock,data,latch" and requests the lines as outputs.
+static int                      gpio_setup(spi_handler* hdlr) {
+  struct gpio_v2_line_request   req;
+  const char*                   lines = strchr(hdlr->config.device, ':');
+  char                          chip[64];
+  gpio_t*                       gpio;
+  int                           fd;
+
+  memset(&req, 0, sizeof(req));
+  if (!lines || (size_t)(lines - hdlr->config.device) >= sizeof(chip) ||
+      sscanf(lines + 1, "%u,%u,%u", &req.offsets[lineClock], &req.offsets[lineData], &req.offsets[lineLatch]) != 3) {
+    errno = EINVAL;
+    return -1;
+  }
+  memcpy(chip, hdlr->config.device, lines - hdlr->config.device);
+  chip[lines - hdlr->config.device] = 0;
+
+  if ((fd = open(chip, O_RDONLY)) < 0) {
+    return -1;
+  }
+  strncpy(req.consumer, "cube", sizeof(req.consumer) - 1);
+  req.num_lines               = lineCount;
+  req.config.flags            = GPIO_V2_LINE_FLAG_OUTPUT;
+  req.config.num_attrs        = 1;
+  req.config.attrs[0].mask    = (1 << lineCount) - 1;
+  req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+  req.config.attrs[0].attr.values = 1 << lineLatch;
+  if (ioctl(fd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+    close(fd);
+    return -1;
+  }
+  close(fd);
+
+  if (!(gpio = calloc(1, sizeof(*gpio)))) {
+    close(req.fd);
+    return -1;
+  }
+  gpio->fd   = req.fd;
+  hdlr->priv = gpio;
+  hdlr->fd   = -1;
+  return 0;
+}
+
+static int      gpio_cleanup(spi_handler* hdlr) {
+  gpio_t*       gpio = hdlr->priv;
+  int           ret;
+
+  ret = close(gpio->fd);
+  free(gpio);
+  hdlr->priv = NULL;
+  return ret;
+}
+
+// spi_gpio_transport bit-bangs the chain with the GPIO character device, for boards
+// without a usable SPI controller. The device is "/dev/gpiochipN:clock,data,latch", the
+// line offsets wired to the 74HC595 SRCLK, SER and RCLK. It runs as fast as the ioctls
+// go, two per bit, the configured speed is ignored. Each word is latched, then held.
+const spi_transport     spi_gpio_transport = {
+  .name           = "gpio",
+  .setup          = gpio_setup,
+  .cleanup        = gpio_cleanup,
+  .transfer       = gpio_transfer,
+  .transfer_frame = gpio_transfer_frame,
+};
@@ -0,0 +1,205 @@
+#define _DEFAULT_SOURCE // For clock_gettime(2) & co. (fix warning on linux).
+#include <errno.h>      // EINTR.
+#include <stdlib.h>     // calloc(3), free(3).
+#include <string.h>     // memcpy(3), memmove(3), memset(3).
+
+#include "spi_sim.h"
+#include "clock.h"      // clock_now_ns, clock_sleep_until.
+
+// Default to a rough spidev ioctl cost.
+uint32_t spi_sim_message_ns = 10000;
+
+// Block like the real device by default.
+int      spi_sim_blocking = 1;
+
+// Hold then latch, as spidev, by default.
+int      spi_sim_latch_first = 0;
+
+typedef struct {
+  uint8_t               chain[SPI_SIM_CHAIN];   // Shift registers, chain[0] being the input.
+  uint8_t               outputs[SPI_SIM_CHAIN]; // Latched outputs.
+  uint64_t              last_ns;                // Host time at the end of the previous transfer.
+  uint64_t              start_ns;               // Simulated time at the beginning of the current transfer.
+  unsigned int          word;                   // Index in its message of the word latched.
+  spi_sim_stats         stats;
+}                       sim_t;
+
+// advance moves the simulated clock forward, accounting the time to the lit layer(s).
+static void     advance(sim_t* sim, uint64_t ns) {
+  uint8_t       cathodes = sim->outputs[SPI_SIM_CHAIN - 1];
+
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    if (cathodes & (0x01 << i)) {
+      sim->stats.layer_ns[i] += ns;
+    }
+  }
+  sim->stats.word_ns[sim->word] += ns;
+  sim->stats.elapsed_ns += ns;
+}
+
+// latch copies the chain to the outputs and decodes what is now displayed, the ith word of its message.
+static void     latch(sim_t* sim, unsigned int word) {
+  uint8_t       previous = sim->outputs[SPI_SIM_CHAIN - 1];
+  uint8_t       cathodes = sim->chain[SPI_SIM_CHAIN - 1];
+
+  memcpy(sim->outputs, sim->chain, sizeof(sim->outputs));
+  sim->word = word;
+  sim->stats.latches++;
+  if (word >= sim->stats.words) {
+    sim->stats.words = word + 1;
+  }
+
+  // A new scan starts each time the first layer comes on.
+  if ((cathodes & 0x01) && !(previous & 0x01)) {
+    sim->stats.frames++;
+  }
+
+  // The first byte sent went the furthest in the chain.
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    if (cathodes & (0x01 << i)) {
+      for (unsigned int j = 0; j < CUBE_SIZE; j++) {
+        sim->stats.displayed[CUBE_SIZE - 1 - i][j] = sim->outputs[SPI_SIM_CHAIN - 2 - j];
+      }
+    }
+  }
+}
+
+// shift_word pushes len bytes in the chain, accounting the wire time.
+static void     shift_word(sim_t* sim, const spi_handler* hdlr, const uint8_t* word, int len) {
+  uint64_t      ns = (uint64_t)len * hdlr->config.bits * NSEC_PER_SEC / hdlr->config.speed;
+
+  for (int i = 0; i < len; i++) {
+    memmove(sim->chain + 1, sim->chain, SPI_SIM_CHAIN - 1);
+    sim->chain[0] = word[i];
+  }
+  sim->stats.bus_ns += ns;
+  advance(sim, ns);
+}
+
+// begin accounts the caller's time since the previous transfer and the message cost.
+static void     begin(sim_t* sim) {
+  uint64_t      now = clock_now_ns();
+
+  if (now > sim->last_ns) {
+    sim->stats.host_ns += now - sim->last_ns;
+    advance(sim, now - sim->last_ns);
+  }
+  sim->start_ns = sim->stats.elapsed_ns;
+  sim->last_ns  = now;
+  advance(sim, spi_sim_message_ns);
+  sim->stats.messages++;
+}
+
+// hold_word runs the hold delay, latching the word before or after as the transport modeled does.
+static void     hold_word(sim_t* sim, unsigned int word, unsigned int hold_us) {
+  if (spi_sim_latch_first) {
+    latch(sim, word);
+  }
+  advance(sim, hold_us * 1000ULL);
+  if (!spi_sim_latch_first) {
+    latch(sim, word);
+  }
+}
+
+// end the message, waiting for its modeled completion if blocking.
+// The next host time measurement is anchored at the modeled end of the message.
+static void     end(sim_t* sim) {
+  sim->last_ns += sim->stats.elapsed_ns - sim->start_ns;
+  if (!spi_sim_blocking) {
+    sim->last_ns = clock_now_ns();
+    return;
+  }
+  while (clock_sleep_until(sim->last_ns) == EINTR);
+}
+
+static int      sim_transfer(const spi_handler* hdlr, const void* tx, void* rx, int len) {
+  sim_t*        sim = hdlr->priv;
+
+  begin(sim);
+  shift_word(sim, hdlr, tx, len);
+  hold_word(sim, 0, hdlr->config.delay);
+  end(sim);
+
+  // Nothing to read back from the chain.
+  if (rx) {
+    memset(rx, 0, len);
+  }
+  return len;
+}
+
+static int              sim_transfer_frame(const spi_handler* hdlr, const void* tx, int len, int count, const uint16_t* holds) {
+  sim_t*                sim  = hdlr->priv;
+  const uint8_t*        word = tx;
+
+  begin(sim);
+  for (int i = 0; i < count; i++, word += len) {
+    shift_word(sim, hdlr, word, len);
+    hold_word(sim, i, spi_sim_latch_first ? (holds ? holds[i] : hdlr->config.delay) : spi_latch_delay(&hdlr->config, holds, i, count));
+  }
+  end(sim);
+
+  return len * count;
+}
+
+static int      sim_setup(spi_handler* hdlr) {
+  sim_t*        sim;
+
+  if (!(sim = calloc(1, sizeof(*sim)))) {
+    return -1;
+  }
+  sim->last_ns = clock_now_ns();
+  hdlr->priv = sim;
+  hdlr->fd   = -1;
+
+  return 0;
+}
+
+static int      sim_cleanup(spi_handler* hdlr) {
+  spi_sim_report(hdlr, stderr);
+  free(hdlr->priv);
+  hdlr->priv = NULL;
+
+  return 0;
+}
+
+// spi_sim_get_stats returns the emulator state of a handler using the sim transport.
+const spi_sim_stats*    spi_sim_get_stats(const spi_handler* hdlr) {
+  return &((const sim_t*)hdlr->priv)->stats;
+}
+
+// spi_sim_report prints the achieved refresh rate and the layers on-time.
+void                    spi_sim_report(const spi_handler* hdlr, FILE* out) {
+  const spi_sim_stats*  stats = spi_sim_get_stats(hdlr);
+  double                elapsed = stats->elapsed_ns ? (double)stats->elapsed_ns : 1;
+
+  fprintf(out, "sim: %.3f s simulated, %llu messages, %llu latches, %llu frames\n",
+          elapsed / 1e9,
+          (unsigned long long)stats->messages,
+          (unsigned long long)stats->latches,
+          (unsigned long long)stats->frames);
+  fprintf(out, "sim: refresh %.1f Hz, bus %.1f%%, host %.1f%%\n",
+          stats->frames * 1e9 / elapsed,
+          stats->bus_ns * 100 / elapsed,
+          stats->host_ns * 100 / elapsed);
+  fprintf(out, "sim: layer on-time");
+  for (unsigned int i = 0; i < CUBE_SIZE; i++) {
+    fprintf(out, " %.1f%%", stats->layer_ns[i] * 100 / elapsed);
+  }
+  fprintf(out, "\n");
+  if (stats->words > 1) {
+    fprintf(out, "sim: word on-time");
+    for (unsigned int i = 0; i < stats->words; i++) {
+      fprintf(out, " %.1f%%", stats->word_ns[i] * 100 / elapsed);
+    }
+    fprintf(out, "\n");
+  }
+}
+
+// spi_sim_transport emulates the 74HC595 chain in process.
+const spi_transport     spi_sim_transport = {
+  .name           = "sim",
+  .setup          = sim_setup,
+  .cleanup        = sim_cleanup,
+  .transfer       = sim_transfer,
+  .transfer_frame = sim_transfer_frame,
+};
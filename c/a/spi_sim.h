@@ -0,0 +1,59 @@
+#ifndef __SPI_SIM_H__
+# define __SPI_SIM_H__
+
+# include <stdio.h>  // FILE.
+# include <stdint.h> // uint64_t & co.
+
+# include "cube.h"   // cube_t.
+# include "spi.h"    // spi_handler, spi_transport.
+
+/**
+   In-process emulator of the daisy-chained 74HC595 driving the cube.
+
+   Each byte sent is shifted in the chain, the chain is latched to the outputs
+   when the chip select is released. The last register of the chain holds the
+   cathodes, the others the anodes, as packed by render_cube.
+
+   Time is simulated: the wire time is derived from the configured speed and bits,
+   the hold delay from the configured delay, and the caller's time in between
+   transfers is measured on the host so the render path cost is accounted for.
+   Like spidev, transfers block until the modeled end of the message, unless
+   spi_sim_blocking is off.
+
+   Like spidev, each word is shifted in, then the hold delay runs and only then the
+   chip select is released and the word latched: the hold keeps the previous word
+   displayed. spi_sim_latch_first models write and gpio instead, latching each word
+   as soon as it is shifted in and holding it after.
+*/
+
+// Number of shift registers in the chain: 1 for the cathodes, CUBE_SIZE for the anodes.
+# define SPI_SIM_CHAIN (CUBE_SIZE + 1)
+
+typedef struct {
+    uint64_t    elapsed_ns;          // Simulated time since setup.
+    uint64_t    bus_ns;              // Time spent shifting bits on the wire.
+    uint64_t    host_ns;             // Time spent by the caller in between transfers.
+    uint64_t    messages;            // Number of messages sent.
+    uint64_t    latches;             // Number of times the outputs got latched.
+    uint64_t    frames;              // Number of full layer scans.
+    uint64_t    layer_ns[CUBE_SIZE]; // Time each cathode layer was on.
+    uint64_t    word_ns[SPI_FRAME_MAX_WORDS]; // Time the ith word of a message stayed latched.
+    unsigned int words;              // Most words seen in a message.
+    cube_t      displayed;           // Last anodes latched for each layer, in hardware layout.
+}               spi_sim_stats;
+
+// Modeled kernel cost of each message (syscall & driver setup), in nsec.
+extern uint32_t spi_sim_message_ns;
+
+// Whether transfers wait for the modeled end of the message.
+extern int      spi_sim_blocking;
+
+// Whether words are latched before their hold delay, as write and gpio do, instead of after as spidev.
+extern int      spi_sim_latch_first;
+
+extern const spi_transport spi_sim_transport;
+
+const spi_sim_stats*    spi_sim_get_stats(const spi_handler* hdlr);
+void                    spi_sim_report(const spi_handler* hdlr, FILE* out);
+
+#endif /* !__SPI_SIM_H__ */
@@ -0,0 +1,148 @@
+#define _DEFAULT_SOURCE     // For clock_nanosleep(2) (fix warning on linux).
+#include <errno.h>          // errno(3).
+#include <string.h>         // memcpy(3), memcmp(3), strncpy(3).
+#include <sys/mman.h>       // PROT_READ.
+
+#include "stats.h"
+
+// layout points the header and the histograms in the mapping.
+static void     layout(stats_t* stats) {
+  stats->header = stats->shm.map;
+  stats->hists  = (stats_hist*)((char*)stats->shm.map + sizeof(stats_header));
+}
+
+// stats_create creates, or replaces, the shared memory object with room for the histograms.
+// Returns -1 with errno set on failure.
+int             stats_create(stats_t* stats, const char* name, unsigned int hists) {
+  size_t        size = sizeof(stats_header) + hists * sizeof(stats_hist);
+
+  memset(stats, 0, sizeof(*stats));
+  if (!hists || hists > STATS_MAX_HISTS) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  // Readers of a previous object see it go.
+  if (shmobj_create(&stats->shm, name, size, 0644) < 0) {
+    return -1;
+  }
+  layout(stats);
+
+  stats->header->version  = STATS_VERSION;
+  stats->header->sub_bits = STATS_SUB_BITS;
+  stats->header->buckets  = STATS_BUCKETS;
+  stats->header->hists    = hists;
+  stats->header->start_ns = clock_now_ns();
+
+  // Readers check the magic first.
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(stats->header->magic, STATS_MAGIC, sizeof(stats->header->magic));
+  return 0;
+}
+
+// stats_open maps an existing shared memory object read only and checks its layout.
+// Returns -1 with errno set on failure.
+int     stats_open(stats_t* stats, const char* name) {
+  memset(stats, 0, sizeof(*stats));
+  if (shmobj_open(&stats->shm, name, sizeof(stats_header), PROT_READ) < 0) {
+    return -1;
+  }
+  layout(stats);
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (memcmp(stats->header->magic, STATS_MAGIC, sizeof(stats->header->magic)) ||
+      stats->header->version != STATS_VERSION ||
+      stats->header->sub_bits != STATS_SUB_BITS ||
+      stats->header->buckets != STATS_BUCKETS ||
+      stats->shm.size != sizeof(stats_header) + stats->header->hists * sizeof(stats_hist)) {
+    stats_close(stats);
+    errno = EINVAL;
+    return -1;
+  }
+  return 0;
+}
+
+// stats_close unmaps the histograms, and removes them if we created them.
+void    stats_close(stats_t* stats) {
+  shmobj_close(&stats->shm);
+}
+
+// stats_add takes the next free histogram, before its writer starts.
+// Returns NULL if none left or without shared memory object, so the measures are disabled.
+stats_hist*     stats_add(stats_t* stats, const char* name) {
+  stats_hist*   hist;
+
+  if (!stats->shm.map || stats->header->count == stats->header->hists) {
+    return NULL;
+  }
+  hist = &stats->hists[stats->header->count];
+  strncpy(hist->name, name, sizeof(hist->name) - 1);
+  __atomic_store_n(&stats->header->count, stats->header->count + 1, __ATOMIC_RELEASE);
+  return hist;
+}
+
+// stats_bucket_value returns the lowest value of the bucket.
+uint64_t        stats_bucket_value(unsigned int bucket) {
+  unsigned int  e;
+
+  if (bucket < 2 * STATS_SUB) {
+    return bucket;
+  }
+  e = bucket / STATS_SUB + STATS_SUB_BITS - 1;
+  return (uint64_t)(STATS_SUB + bucket % STATS_SUB) << (e - STATS_SUB_BITS);
+}
+
+// stats_percentile returns the value below which the percentile of the values fall,
+// the middle of its bucket within min and max, 0 if empty.
+uint64_t        stats_percentile(const stats_hist* hist, double percentile) {
+  uint64_t      counts[STATS_BUCKETS];
+  uint64_t      total = 0;
+  uint64_t      rank;
+  uint64_t      seen  = 0;
+  uint64_t      value = stats_bucket_value(STATS_BUCKETS - 1);
+  uint64_t      min   = __atomic_load_n(&hist->min_ns, __ATOMIC_RELAXED);
+  uint64_t      max   = __atomic_load_n(&hist->max_ns, __ATOMIC_RELAXED);
+
+  for (unsigned int i = 0; i < STATS_BUCKETS; i++) {
+    counts[i]  = __atomic_load_n(&hist->buckets[i], __ATOMIC_RELAXED);
+    total     += counts[i];
+  }
+  if (!total) {
+    return 0;
+  }
+  rank = (uint64_t)(percentile / 100 * total + 0.5);
+  if (rank < 1) {
+    rank = 1;
+  }
+  for (unsigned int i = 0; i + 1 < STATS_BUCKETS; i++) {
+    if ((seen += counts[i]) >= rank) {
+      value = (stats_bucket_value(i) + stats_bucket_value(i + 1)) / 2;
+      break;
+    }
+  }
+  return value < min ? min : value > max ? max : value;
+}
+
+// stats_report prints the count and the percentiles (usec) of the histogram, tab separated.
+void            stats_report(const stats_hist* hist, FILE* out) {
+  uint64_t      count = __atomic_load_n(&hist->count, __ATOMIC_RELAXED);
+
+  fprintf(out, "%s\t%llu\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\n",
+          hist->name, (unsigned long long)count,
+          __atomic_load_n(&hist->min_ns, __ATOMIC_RELAXED) / 1e3,
+          __atomic_load_n(&hist->sum_ns, __ATOMIC_RELAXED) / (double)(count ? count : 1) / 1e3,
+          stats_percentile(hist, 50) / 1e3,
+          stats_percentile(hist, 90) / 1e3,
+          stats_percentile(hist, 99) / 1e3,
+          stats_percentile(hist, 99.9) / 1e3,
+          __atomic_load_n(&hist->max_ns, __ATOMIC_RELAXED) / 1e3);
+}
+
+// stats_print prints all the histograms in use, after a header line.
+void            stats_print(const stats_t* stats, FILE* out) {
+  unsigned int  count = __atomic_load_n(&stats->header->count, __ATOMIC_ACQUIRE);
+
+  fprintf(out, "name\tcount\tmin\tmean\tp50\tp90\tp99\tp99.9\tmax\n");
+  for (unsigned int i = 0; i < count && i < stats->header->hists; i++) {
+    stats_report(&stats->hists[i], out);
+  }
+}
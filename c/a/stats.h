@@ -0,0 +1,127 @@
+#ifndef __STATS_H__
+# define __STATS_H__
+
+# include <stddef.h> // size_t.
+# include <stdint.h> // uint64_t & co.
+# include <stdio.h>  // FILE.
+
+# include "clock.h"  // clock_now_ns.
+# include "shmobj.h" // shmobj_t.
+
+/**
+   Latency histograms of the hot paths, published in shared memory so an external
+   tool (cubestat) can read them while the cubes run.
+
+   The renderer creates /dev/shm/<name>. Layout, host byte order, 64 bytes aligned:
+
+   stats_header                  Magic "CUBESTA", version, bucket layout, histograms in use.
+   stats_hist[hists]             Per histogram: name, count, sum, min, max, buckets.
+
+   Histograms are HDR style, log-linear: values below 2^(STATS_SUB_BITS + 1) ns get
+   a bucket each, then each power of 2 gets 2^STATS_SUB_BITS buckets, so a bucket is
+   within 1/16 of its values up to 2^STATS_MAX_BITS ns, the last bucket taking the rest.
+
+   Each histogram has a single writer, which stores the counters with relaxed atomics:
+   recording is a bucket index, a few loads and stores, no lock and no RMW. Readers
+   see each counter whole, the counters of a histogram possibly one record apart.
+
+   Example:
+
+   stats_hist*   step = stats_add(&stats, "scene step"); // NULL when disabled.
+   uint64_t      start = stats_start(step);
+
+   scene(...);
+   stats_stop(step, start);
+*/
+
+# define STATS_MAGIC     "CUBESTA"
+# define STATS_VERSION   1
+
+// Bucket layout.
+# define STATS_SUB_BITS  4
+# define STATS_SUB       (1 << STATS_SUB_BITS)
+# define STATS_MAX_BITS  36 // ~68 sec.
+# define STATS_BUCKETS   ((STATS_MAX_BITS - STATS_SUB_BITS + 1) * STATS_SUB)
+
+// Maximum number of histograms.
+# define STATS_MAX_HISTS 64
+
+typedef struct {
+    char            magic[8];   // STATS_MAGIC, set last by the creator.
+    uint32_t        version;    // STATS_VERSION.
+    uint32_t        sub_bits;   // STATS_SUB_BITS.
+    uint32_t        buckets;    // STATS_BUCKETS.
+    uint32_t        hists;      // Number of histograms allocated.
+    uint32_t        count;      // Number of histograms in use.
+    uint32_t        reserved0;
+    uint64_t        start_ns;   // Monotonic time of the creation.
+    uint8_t         reserved[24];
+}                   stats_header;
+
+typedef struct {
+    char            name[32];
+    uint64_t        count;      // Number of values recorded.
+    uint64_t        sum_ns;
+    uint64_t        min_ns;
+    uint64_t        max_ns;
+    uint64_t        buckets[STATS_BUCKETS];
+}                   stats_hist;
+
+typedef struct {
+    shmobj_t        shm;
+    stats_header*   header;
+    stats_hist*     hists;
+}                   stats_t;
+
+// stats_bucket returns the bucket of the value.
+static inline unsigned int      stats_bucket(uint64_t value) {
+  unsigned int                  e;
+
+  if (value < STATS_SUB) {
+    return value;
+  }
+  e = 63 - __builtin_clzll(value);
+  if (e >= STATS_MAX_BITS) {
+    return STATS_BUCKETS - 1;
+  }
+  return (e - STATS_SUB_BITS + 1) * STATS_SUB + ((value >> (e - STATS_SUB_BITS)) & (STATS_SUB - 1));
+}
+
+// stats_record adds the value to the histogram. Single writer.
+static inline void      stats_record(stats_hist* hist, uint64_t value) {
+  uint64_t*             bucket = &hist->buckets[stats_bucket(value)];
+
+  __atomic_store_n(bucket, *bucket + 1, __ATOMIC_RELAXED);
+  if (!hist->count || value < hist->min_ns) {
+    __atomic_store_n(&hist->min_ns, value, __ATOMIC_RELAXED);
+  }
+  if (value > hist->max_ns) {
+    __atomic_store_n(&hist->max_ns, value, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&hist->sum_ns, hist->sum_ns + value, __ATOMIC_RELAXED);
+  __atomic_store_n(&hist->count, hist->count + 1, __ATOMIC_RELAXED);
+}
+
+// stats_start returns the start time of a measure, 0 without histogram so disabled
+// measures don't read the clock.
+static inline uint64_t  stats_start(const stats_hist* hist) {
+  return hist ? clock_now_ns() : 0;
+}
+
+// stats_stop records the time since the start of the measure, if any histogram.
+static inline void      stats_stop(stats_hist* hist, uint64_t start) {
+  if (hist) {
+    stats_record(hist, clock_now_ns() - start);
+  }
+}
+
+int             stats_create(stats_t* stats, const char* name, unsigned int hists);
+int             stats_open(stats_t* stats, const char* name);
+void            stats_close(stats_t* stats);
+stats_hist*     stats_add(stats_t* stats, const char* name);
+uint64_t        stats_bucket_value(unsigned int bucket);
+uint64_t        stats_percentile(const stats_hist* hist, double percentile);
+void            stats_report(const stats_hist* hist, FILE* out);
+void            stats_print(const stats_t* stats, FILE* out);
+
+#endif /* !__STATS_H__ */
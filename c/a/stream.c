@@ -0,0 +1,143 @@
+#define _DEFAULT_SOURCE // For getopt(3) & htole64(3) (fix warning on linux).
+#include <endian.h>     // htole64(3) & co.
+#include <errno.h>      // errno(3).
+#include <signal.h>     // signal(2).
+#include <stdio.h>      // fprintf(3), perror(3).
+#include <stdlib.h>     // strtoul(3), strtoull(3).
+#include <string.h>     // memset(3), memcpy(3).
+#include <sys/socket.h> // socket(2), sendto(2).
+#include <time.h>       // time(2) (for random seeds).
+#include <unistd.h>     // getopt(3), close(2).
+
+#include "clock.h"      // Monotonic clock.
+#include "cube.h"       // Cube managment.
+#include "ingest.h"     // Frame ingest.
+#include "kernels.h"    // Cube kernels.
+#include "scenes.h"     // Scenes.
+
+/**
+   stream runs a scene and sends its frames to a cube started with -i, as a local
+   sender to measure the ingest path.
+
+   Frames are sent as the scene changes them, or at a fixed rate with -r to load
+   the ingest. With -l, each frame is due lead usec after being sent, on the shared
+   monotonic clock, so it only works on the same machine; otherwise frames are shown
+   on arrival.
+*/
+
+static volatile int _running = 1;
+
+static void intHandler() {
+    _running = 0;
+}
+
+static void     usage(const char* name) {
+  fprintf(stderr, "usage: %s [-r rate] [-n frames] [-u cube] [-l lead] [-s seed] address scene\n", name);
+  fprintf(stderr, "  -r rate       Send the current frame at rate Hz (default: when the scene changes it).\n");
+  fprintf(stderr, "  -n frames     Stop after sending frames (default: on SIGINT).\n");
+  fprintf(stderr, "  -u cube       Index of the cube to send to (default 0).\n");
+  fprintf(stderr, "  -l lead       Present each frame lead usec after sending it (default: on arrival).\n");
+  fprintf(stderr, "  -s seed       Seed of the scene (default: time).\n");
+  fprintf(stderr, "address: udp:[host:]port or unix:path.\n");
+}
+
+int                     main(int argc, char** argv) {
+  const scene_desc*     desc;
+  scene_t               scene;
+  cube_t                cube;
+  ingest_packet         packet;
+  struct sockaddr_storage addr;
+  socklen_t             len;
+  uint64_t              rate   = 0;
+  uint64_t              frames = UINT64_MAX;
+  uint64_t              lead   = 0;
+  uint64_t              sent   = 0;
+  uint64_t              errors = 0;
+  uint64_t              start;
+  uint64_t              now;
+  uint64_t              next_step;
+  uint64_t              next_send;
+  unsigned long         generation;
+  int                   fd;
+  int                   opt;
+
+  memset(&scene, 0, sizeof(scene));
+  memset(&packet, 0, sizeof(packet));
+  rng_seed(&scene.rng, time(NULL));
+
+  while ((opt = getopt(argc, argv, "r:n:u:l:s:")) != -1) {
+    switch (opt) {
+    case 'r':
+      rate = strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      frames = strtoul(optarg, NULL, 10);
+      break;
+    case 'u':
+      packet.unit = htole32(strtoul(optarg, NULL, 10));
+      break;
+    case 'l':
+      lead = strtoul(optarg, NULL, 10) * 1000;
+      break;
+    case 's':
+      rng_seed(&scene.rng, strtoull(optarg, NULL, 10));
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (argc - optind != 2 || !(desc = scene_lookup(argv[optind + 1]))) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (ingest_address(argv[optind], 0, &addr, &len) < 0 || (fd = socket(addr.ss_family, SOCK_DGRAM, 0)) < 0) {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  signal(SIGINT, intHandler);
+  signal(SIGTERM, intHandler);
+
+  cube_kernels_init(NULL);
+  clear_cube(cube);
+
+  start     = clock_now_ns();
+  next_step = start;
+  next_send = UINT64_MAX;
+  while (_running && sent < frames) {
+    // Step the scene when due, sending the changed frames unless sending at a fixed rate.
+    now = clock_now_ns();
+    if (now >= next_step) {
+      generation = cube_generation();
+      next_step += desc->step(&scene, cube) * 1000;
+      if (next_step < now) {
+        next_step = now;
+      }
+      if (!rate && cube_generation() != generation) {
+        next_send = now;
+      }
+    }
+    if (rate && next_send == UINT64_MAX) {
+      next_send = start;
+    }
+
+    if (now >= next_send) {
+      packet.seq    = htole64(++sent);
+      packet.pts_ns = htole64(lead ? now + lead : 0);
+      memcpy(packet.frame, cube, sizeof(cube_t));
+      if (sendto(fd, &packet, sizeof(packet), 0, (struct sockaddr*)&addr, len) < 0) {
+        errors++;
+      }
+      next_send = rate ? next_send + NSEC_PER_SEC / rate : UINT64_MAX;
+    }
+
+    clock_sleep_until(next_step < next_send ? next_step : next_send);
+  }
+
+  now = clock_now_ns();
+  fprintf(stderr, "stream: %llu frames sent in %.3f s (%.0f Hz), %llu errors\n",
+          (unsigned long long)sent, (now - start) / 1e9, sent * 1e9 / (now - start), (unsigned long long)errors);
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef __TRIBUF_H__
+# define __TRIBUF_H__
+
+# include "cube.h" // cube_t.
+
+/**
+   Lock-free triple buffer of cubes, for a single writer and a single reader.
+
+   The writer draws in the back slot and publishes it, the reader swaps in the
+   latest published slot as front. Neither side ever waits on the other, and the
+   reader always sees a complete frame.
+*/
+
+// Flag set on the middle slot index when it holds a frame the reader didn't take yet.
+# define TRIBUF_FRESH 0x04
+
+typedef struct {
+    cube_t          slots[3];
+    unsigned int    back;   // Writer owned.
+    unsigned int    middle; // Shared, slot index | TRIBUF_FRESH.
+    unsigned int    front;  // Reader owned.
+}                   tribuf_t;
+
+// tribuf_back is the slot the writer draws in.
+# define tribuf_back(t)  ((t)->slots[(t)->back])
+// tribuf_front is the slot the reader displays.
+# define tribuf_front(t) ((t)->slots[(t)->front])
+
+// tribuf_init resets the buffer, all slots cleared.
+static inline void tribuf_init(tribuf_t* t) {
+  for (unsigned int i = 0; i < 3; i++) {
+    clear_cube(t->slots[i]);
+  }
+  t->back   = 0;
+  t->middle = 1;
+  t->front  = 2;
+}
+
+// tribuf_publish hands the back slot over to the reader and takes a new back slot.
+static inline void tribuf_publish(tribuf_t* t) {
+  t->back = __atomic_exchange_n(&t->middle, t->back | TRIBUF_FRESH, __ATOMIC_ACQ_REL) & ~TRIBUF_FRESH;
+}
+
+// tribuf_swap takes the latest published slot as front, if any.
+// Returns 1 if the front changed, 0 otherwise.
+static inline int tribuf_swap(tribuf_t* t) {
+  if (!(__atomic_load_n(&t->middle, __ATOMIC_RELAXED) & TRIBUF_FRESH)) {
+    return 0;
+  }
+  t->front = __atomic_exchange_n(&t->middle, t->front, __ATOMIC_ACQ_REL) & ~TRIBUF_FRESH;
+  return 1;
+}
+
+#endif /* !__TRIBUF_H__ */
@@ -0,0 +1,58 @@
+#include "voxset.h"
+
+// place puts the voxel at the given position of dense, swapping with the one there.
+static inline void      place(voxset_t* set, unsigned int i, unsigned int to) {
+  unsigned int          from  = set->pos[i];
+  unsigned int          other = set->dense[to];
+
+  set->dense[from] = other;
+  set->pos[other]  = from;
+  set->dense[to]   = i;
+  set->pos[i]      = to;
+}
+
+// voxset_init builds the set of the voxels on in the cube.
+void            voxset_init(voxset_t* set, cube_t cube) {
+  unsigned int  on  = 0;
+  unsigned int  off = VOXSET_SIZE;
+
+  for (unsigned int i = 0; i < VOXSET_SIZE; i++) {
+    unsigned int p = get_voxel(cube, voxset_x(i), voxset_y(i), voxset_z(i)) ? on++ : --off;
+
+    set->dense[p] = i;
+    set->pos[i]   = p;
+  }
+  set->count = on;
+}
+
+// voxset_set turns the ith voxel on, in the set and the cube.
+void    voxset_set(voxset_t* set, cube_t cube, unsigned int i) {
+  if (set->pos[i] >= set->count) {
+    place(set, i, set->count++);
+  }
+  set_voxel(cube, voxset_x(i), voxset_y(i), voxset_z(i));
+}
+
+// voxset_clear turns the ith voxel off, in the set and the cube.
+void    voxset_clear(voxset_t* set, cube_t cube, unsigned int i) {
+  if (set->pos[i] < set->count) {
+    place(set, i, --set->count);
+  }
+  clear_voxel(cube, voxset_x(i), voxset_y(i), voxset_z(i));
+}
+
+// voxset_pick_set returns a random voxel on, -1 if none.
+int     voxset_pick_set(const voxset_t* set, rng_t* rng) {
+  if (!set->count) {
+    return -1;
+  }
+  return set->dense[rng_below(rng, set->count)];
+}
+
+// voxset_pick_clear returns a random voxel off, -1 if none.
+int     voxset_pick_clear(const voxset_t* set, rng_t* rng) {
+  if (set->count == VOXSET_SIZE) {
+    return -1;
+  }
+  return set->dense[set->count + rng_below(rng, VOXSET_SIZE - set->count)];
+}
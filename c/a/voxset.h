@@ -0,0 +1,50 @@
+#ifndef __VOXSET_H__
+# define __VOXSET_H__
+
+# include <stdint.h> // uint16_t.
+
+# include "cube.h"   // cube_t.
+# include "rng.h"    // rng_t.
+
+/**
+   Sparse set of the voxels on, to pick a random voxel on or off in constant time,
+   however full the cube is.
+
+   dense is a permutation of all the voxel indices, the voxels on first: dense[0, count)
+   are on, dense[count, VOXSET_SIZE) off. pos is the position of each voxel in dense.
+   Turning a voxel on or off swaps it across the boundary, picking one is a random
+   position on either side.
+
+   The set mirrors the cube it was initialized from, as long as the voxels are turned
+   on and off through it.
+
+   Example:
+
+   voxset_init(&set, cube);
+   if ((i = voxset_pick_clear(&set, &scene->rng)) >= 0) {
+     voxset_set(&set, cube, i);
+   }
+*/
+
+// Number of voxels.
+# define VOXSET_SIZE (CUBE_SIZE * CUBE_SIZE * CUBE_SIZE)
+
+typedef struct {
+    uint16_t        count;              // Number of voxels on.
+    uint16_t        dense[VOXSET_SIZE]; // Voxels on, then voxels off.
+    uint16_t        pos[VOXSET_SIZE];   // Position of each voxel in dense.
+}                   voxset_t;
+
+// Voxel index of x*y*z, and back.
+# define voxset_index(x, y, z) ((((y) * CUBE_SIZE) + (z)) * CUBE_SIZE + (x))
+# define voxset_x(i)           ((i) % CUBE_SIZE)
+# define voxset_y(i)           ((i) / (CUBE_SIZE * CUBE_SIZE))
+# define voxset_z(i)           ((i) / CUBE_SIZE % CUBE_SIZE)
+
+void    voxset_init(voxset_t* set, cube_t cube);
+void    voxset_set(voxset_t* set, cube_t cube, unsigned int i);
+void    voxset_clear(voxset_t* set, cube_t cube, unsigned int i);
+int     voxset_pick_set(const voxset_t* set, rng_t* rng);
+int     voxset_pick_clear(const voxset_t* set, rng_t* rng);
+
+#endif /* !__VOXSET_H__ */
@@ -0,0 +1,160 @@
+#include <cstdio>   // std::fprintf.
+#include <cstring>  // std::memcmp.
+#include <random>   // std::mt19937.
+
+#include "cube.hpp" // cube::Cube & co.
+
+extern "C" {
+#include "cube.h"   // cube_t & co.
+#include "remap.h"  // remap_compile, remap_apply, pack_layer.
+}
+
+/**
+   Checks of the C++ cube core, exits 1 on the first mismatch.
+
+   8x8x8: Packer against the C remap_apply and pack_layer, on the loop.c
+   wiring and the straight one.
+
+   Other sizes: Packer against a voxel by voxel packing of the frame, as laid
+   out in cube.hpp.
+*/
+
+// Random cubes checked on each size and wiring, on top of the empty and full ones.
+constexpr unsigned int check_cubes = 256;
+
+static std::mt19937     rng(1);
+
+// Wirings checked, static so Packer can take them as template parameters.
+constexpr auto          default_8  = cube::default_wiring<8, 8, 8>();
+constexpr auto          straight_8 = cube::straight_wiring<8, 8, 8>();
+constexpr auto          default_4  = cube::default_wiring<4, 4, 4>();
+constexpr auto          straight_4 = cube::straight_wiring<4, 4, 4>();
+constexpr auto          default_16 = cube::default_wiring<16, 16, 16>();
+constexpr auto          default_prism = cube::default_wiring<5, 3, 12>();
+
+// fill_cube sets the voxels of the ith cube: none, all, then random ones.
+template <typename CubeT>
+static void     fill_cube(CubeT& cube, unsigned int i) {
+  cube.clear();
+  for (std::size_t x = 0; x < CubeT::x_len; x++) {
+    for (std::size_t y = 0; y < CubeT::y_len; y++) {
+      for (std::size_t z = 0; z < CubeT::z_len; z++) {
+        if (i == 1 || (i > 1 && rng() % 2)) {
+          cube.set_voxel(x, y, z);
+        }
+      }
+    }
+  }
+}
+
+// reference packs the frame one voxel at the time, from the layout documented in cube.hpp.
+template <typename CubeT, typename PackerT, typename WiringT>
+static void     reference(const CubeT& cube, const WiringT& w, typename PackerT::frame_type& tx) {
+  constexpr std::size_t X = CubeT::x_len;
+  constexpr std::size_t Y = CubeT::y_len;
+  constexpr std::size_t Z = CubeT::z_len;
+
+  for (std::size_t i = 0; i < Y; i++) {
+    tx[i].fill(0);
+    tx[i][i / 8] = 1 << i % 8;
+  }
+  for (std::size_t x = 0; x < X; x++) {
+    for (std::size_t y = 0; y < Y; y++) {
+      for (std::size_t z = 0; z < Z; z++) {
+        if (cube.get_voxel(x, y, z)) {
+          std::size_t b = (Z - 1 - w.z_map[x][z]) * X + w.x_map[z][x];
+
+          tx[w.y_map[x][y]][PackerT::cathode_bytes + b / 8] |= 1 << b % 8;
+        }
+      }
+    }
+  }
+}
+
+// check_reference checks Packer against the reference on the wiring.
+template <typename CubeT, const auto& W>
+static int      check_reference(const char* name) {
+  using PackerT = cube::Packer<CubeT, W>;
+
+  CubeT                         cube;
+  typename PackerT::frame_type  got;
+  typename PackerT::frame_type  want;
+
+  for (unsigned int i = 0; i < check_cubes + 2; i++) {
+    fill_cube(cube, i);
+    PackerT::pack(cube, got);
+    reference<CubeT, PackerT>(cube, W, want);
+    if (got != want) {
+      std::fprintf(stderr, "packer %s: mismatch with the reference on cube %u\n", name, i);
+      return -1;
+    }
+  }
+  std::printf("packer %s: %u cubes ok\n", name, check_cubes + 2);
+  return 0;
+}
+
+// check_c checks the 8x8x8 Packer against remap_apply and pack_layer on the wiring.
+template <const auto& W>
+static int      check_c(const char* name) {
+  using CubeT   = cube::Cube<8, 8, 8>;
+  using PackerT = cube::Packer<CubeT, W>;
+
+  static_assert(PackerT::word_bytes == CUBE_SIZE + 1, "not the C SPI word");
+
+  wiring_t                      x_map;
+  wiring_t                      y_map;
+  wiring_t                      z_map;
+  remap_t                       remap;
+  CubeT                         cube;
+  cube_t                        c_cube;
+  cube_t                        mapped_cube;
+  typename PackerT::frame_type  got;
+  cube_size_t                   want[CUBE_SIZE + 1];
+
+  for (std::size_t i = 0; i < CUBE_SIZE; i++) {
+    for (std::size_t j = 0; j < CUBE_SIZE; j++) {
+      x_map[i][j] = W.x_map[i][j];
+      y_map[i][j] = W.y_map[i][j];
+      z_map[i][j] = W.z_map[i][j];
+    }
+  }
+  remap_compile(&remap, x_map, y_map, z_map);
+
+  for (unsigned int i = 0; i < check_cubes + 2; i++) {
+    fill_cube(cube, i);
+    clear_cube(c_cube);
+    for (std::size_t x = 0; x < CUBE_SIZE; x++) {
+      for (std::size_t y = 0; y < CUBE_SIZE; y++) {
+        for (std::size_t z = 0; z < CUBE_SIZE; z++) {
+          if (cube.get_voxel(x, y, z)) {
+            set_voxel(c_cube, x, y, z);
+          }
+        }
+      }
+    }
+    PackerT::pack(cube, got);
+    remap_apply(&remap, c_cube, mapped_cube);
+    for (unsigned int y = 0; y < CUBE_SIZE; y++) {
+      pack_layer(want, mapped_cube, y);
+      if (std::memcmp(got[y].data(), want, sizeof(want))) {
+        std::fprintf(stderr, "packer %s: layer %u mismatch with the C packing on cube %u\n", name, y, i);
+        return -1;
+      }
+    }
+  }
+  std::printf("packer %s: %u cubes ok\n", name, check_cubes + 2);
+  return 0;
+}
+
+int     main() {
+  if (check_c<default_8>("8x8x8 default, C") < 0 ||
+      check_c<straight_8>("8x8x8 straight, C") < 0 ||
+      check_reference<cube::Cube<8, 8, 8>, default_8>("8x8x8 default") < 0 ||
+      check_reference<cube::Cube<4, 4, 4>, default_4>("4x4x4 default") < 0 ||
+      check_reference<cube::Cube<4, 4, 4>, straight_4>("4x4x4 straight") < 0 ||
+      check_reference<cube::Cube<16, 16, 16>, default_16>("16x16x16 default") < 0 ||
+      check_reference<cube::Cube<5, 3, 12>, default_prism>("5x3x12 default") < 0) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,370 @@
+#ifndef __CUBE_HPP__
+# define __CUBE_HPP__
+
+# include <array>       // std::array.
+# include <cstddef>     // std::size_t.
+# include <cstdint>     // uint8_t & co.
+# include <type_traits> // std::conditional_t.
+# include <utility>     // std::index_sequence.
+
+/**
+   Header only C++ cube core, for any size of cube. Needs C++17 (if constexpr,
+   fold expressions, auto template parameters), checked by make check here.
+
+   Cube<X, Y, Z, Word> keeps the C layout: one Word per X row, rows indexed
+   [Y - 1 - y][Z - 1 - z], bit x. The wiring tables and the SPI packing plan
+   are generated at compile time for each size, so each cube gets its own
+   unrolled, branch free pack instead of the generic loops of the C version.
+   Frame bytes fed by a single X row, in order or reversed, are packed as a
+   shifted row, the other ones bit by bit.
+
+   The SPI word of each cathode layer is the cathode bytes followed by the
+   anode bytes of the daisy chained 595s, like the 8x8x8 unit:
+     - cathode i is bit i % 8 of byte i / 8,
+     - anode (x, z) is bit b % 8 of byte cathode_bytes + b / 8, b = (Z - 1 - z) * X + x.
+*/
+
+namespace cube {
+
+// Enum for shift direction.
+enum class Shift { PosX, NegX, PosY, NegY, PosZ, NegZ };
+
+// Enum for axis select.
+enum class Axis { X, Y, Z };
+
+// word_for_t is the smallest unsigned type holding a X row of n bits.
+template <std::size_t N>
+using word_for_t = std::conditional_t<(N <= 8), uint8_t,
+                   std::conditional_t<(N <= 16), uint16_t,
+                   std::conditional_t<(N <= 32), uint32_t, uint64_t>>>;
+
+// Cube is the in-memory representation of a X*Y*Z cube.
+template <std::size_t X, std::size_t Y, std::size_t Z, typename Word = word_for_t<X>>
+class Cube {
+  static_assert(X > 0 && Y > 0 && Z > 0, "empty cube");
+  static_assert(X <= sizeof(Word) * 8, "X rows don't fit in the storage word");
+
+ public:
+  using word_type = Word;
+
+  static constexpr std::size_t x_len = X;
+  static constexpr std::size_t y_len = Y;
+  static constexpr std::size_t z_len = Z;
+
+  // set_voxel turns on the x*y*z LED.
+  constexpr void set_voxel(std::size_t x, std::size_t y, std::size_t z) noexcept {
+    row(y, z) |= Word(1) << x;
+  }
+
+  // clear_voxel turns off the x*y*z LED.
+  constexpr void clear_voxel(std::size_t x, std::size_t y, std::size_t z) noexcept {
+    row(y, z) &= ~(Word(1) << x);
+  }
+
+  // get_voxel checks if the x*y*z LED is on.
+  constexpr bool get_voxel(std::size_t x, std::size_t y, std::size_t z) const noexcept {
+    return (row(y, z) >> x) & 1;
+  }
+
+  // clear turns off the whole cube.
+  constexpr void clear() noexcept {
+    for (auto& r : state_) {
+      r = 0;
+    }
+  }
+
+  // shift slides the whole cube on the given direction.
+  constexpr void shift(Shift dir) noexcept {
+    switch (dir) {
+    case Shift::PosX:
+      for (auto& r : state_) {
+        r = (r << 1) & x_mask;
+      }
+      break;
+    case Shift::NegX:
+      for (auto& r : state_) {
+        r >>= 1;
+      }
+      break;
+    case Shift::PosY:
+      for (std::size_t i = 0; i < (Y - 1) * Z; i++) {
+        state_[i] = state_[i + Z];
+      }
+      for (std::size_t i = (Y - 1) * Z; i < Y * Z; i++) {
+        state_[i] = 0;
+      }
+      break;
+    case Shift::NegY:
+      for (std::size_t i = Y * Z; i-- > Z;) {
+        state_[i] = state_[i - Z];
+      }
+      for (std::size_t i = 0; i < Z; i++) {
+        state_[i] = 0;
+      }
+      break;
+    case Shift::PosZ:
+      for (std::size_t i = 0; i < Y * Z; i++) {
+        state_[i] = i % Z == Z - 1 ? 0 : state_[i + 1];
+      }
+      break;
+    case Shift::NegZ:
+      for (std::size_t i = Y * Z; i-- > 0;) {
+        state_[i] = i % Z == 0 ? 0 : state_[i - 1];
+      }
+      break;
+    }
+  }
+
+  // set_plane turns on the Nth plane from the given axis.
+  constexpr void set_plane(Axis axis, std::size_t n) noexcept {
+    for (std::size_t i = 0; i < Y * Z; i++) {
+      switch (axis) {
+      case Axis::X:
+        state_[i] |= Word(1) << n;
+        break;
+      case Axis::Y:
+        state_[i] |= i / Z == Y - 1 - n ? x_mask : 0;
+        break;
+      case Axis::Z:
+        state_[i] |= i % Z == Z - 1 - n ? x_mask : 0;
+        break;
+      }
+    }
+  }
+
+  // data returns the rows, indexed [Y - 1 - y][Z - 1 - z].
+  constexpr const Word* data() const noexcept {
+    return state_.data();
+  }
+
+ private:
+  static constexpr Word x_mask = X == sizeof(Word) * 8 ? Word(~Word(0)) : Word((Word(1) << X) - 1);
+
+  constexpr Word& row(std::size_t y, std::size_t z) noexcept {
+    return state_[(Y - 1 - y) * Z + (Z - 1 - z)];
+  }
+
+  constexpr const Word& row(std::size_t y, std::size_t z) const noexcept {
+    return state_[(Y - 1 - y) * Z + (Z - 1 - z)];
+  }
+
+  std::array<Word, Y * Z> state_{};
+};
+
+// Wiring maps the memory cube to the hardware one, like the x_map/y_map/z_map C tables.
+template <std::size_t X, std::size_t Y, std::size_t Z>
+struct Wiring {
+  std::array<std::array<std::size_t, X>, Z> x_map{}; // X wiring on Z axis: x_map[z][x].
+  std::array<std::array<std::size_t, Y>, X> y_map{}; // Y wiring on X axis: y_map[x][y].
+  std::array<std::array<std::size_t, Z>, X> z_map{}; // Z wiring on X axis: z_map[x][z].
+
+  // valid checks that each mapping stays in the cube.
+  constexpr bool valid() const noexcept {
+    for (std::size_t i = 0; i < X; i++) {
+      for (std::size_t j = 0; j < Z; j++) {
+        if (x_map[j][i] >= X || z_map[i][j] >= Z) {
+          return false;
+        }
+      }
+      for (std::size_t j = 0; j < Y; j++) {
+        if (y_map[i][j] >= Y) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+// straight_wiring maps each voxel to itself.
+template <std::size_t X, std::size_t Y, std::size_t Z>
+constexpr Wiring<X, Y, Z> straight_wiring() noexcept {
+  Wiring<X, Y, Z> w;
+
+  for (std::size_t i = 0; i < X; i++) {
+    for (std::size_t j = 0; j < Z; j++) {
+      w.x_map[j][i] = i;
+      w.z_map[i][j] = j;
+    }
+    for (std::size_t j = 0; j < Y; j++) {
+      w.y_map[i][j] = j;
+    }
+  }
+  return w;
+}
+
+// default_wiring is the wiring of the 8x8x8 unit for any size: the X rows run
+// back and forth along Z, and the Z rows are swapped by pairs.
+template <std::size_t X, std::size_t Y, std::size_t Z>
+constexpr Wiring<X, Y, Z> default_wiring() noexcept {
+  Wiring<X, Y, Z> w = straight_wiring<X, Y, Z>();
+
+  for (std::size_t i = 0; i < X; i++) {
+    for (std::size_t j = 0; j < Z; j++) {
+      w.x_map[j][i] = j % 2 ? X - 1 - i : i;
+      w.z_map[i][j] = (j ^ 1) < Z ? j ^ 1 : j;
+    }
+  }
+  return w;
+}
+
+// Packer maps and packs a cube in the SPI frame, one word per cathode layer.
+// The source bit of each frame bit is resolved at compile time from the wiring.
+template <typename CubeT, const auto& W>
+class Packer {
+  static constexpr std::size_t X = CubeT::x_len;
+  static constexpr std::size_t Y = CubeT::y_len;
+  static constexpr std::size_t Z = CubeT::z_len;
+
+  static_assert(W.valid(), "wiring out of the cube");
+
+ public:
+  static constexpr std::size_t cathode_bytes = (Y + 7) / 8;
+  static constexpr std::size_t anode_bytes   = (X * Z + 7) / 8;
+  static constexpr std::size_t word_bytes    = cathode_bytes + anode_bytes;
+
+  using frame_type = std::array<std::array<uint8_t, word_bytes>, Y>;
+
+  // pack fills the frame, every bit of it.
+  static void pack(const CubeT& cube, frame_type& tx) noexcept {
+    pack_bytes(cube.data(), tx, std::make_index_sequence<Y * anode_bytes>());
+  }
+
+ private:
+  // Source of a frame bit: the cube row and bit, none being a zero row past the cube.
+  struct Source {
+    std::size_t row = Y * Z;
+    std::size_t bit = 0;
+  };
+
+  using plan_type = std::array<std::array<Source, 8>, Y * anode_bytes>;
+
+  // plan walks the cube once, sending each voxel where the wiring puts it.
+  static constexpr plan_type make_plan() noexcept {
+    plan_type   plan{};
+
+    for (std::size_t x = 0; x < X; x++) {
+      for (std::size_t y = 0; y < Y; y++) {
+        for (std::size_t z = 0; z < Z; z++) {
+          std::size_t xx = W.x_map[z][x];
+          std::size_t yy = W.y_map[x][y];
+          std::size_t zz = W.z_map[x][z];
+          std::size_t b  = (Z - 1 - zz) * X + xx;
+
+          plan[yy * anode_bytes + b / 8][b % 8] = Source{(Y - 1 - y) * Z + (Z - 1 - z), x};
+        }
+      }
+    }
+    return plan;
+  }
+
+  static constexpr plan_type plan = make_plan();
+
+  // Row of a frame byte taking its bits from a single source row, in order or reversed.
+  struct Run {
+    int         kind = 0; // 0: bit by bit, 1: in order, 2: reversed.
+    std::size_t row  = 0;
+    std::size_t base = 0; // Source bit of frame bit 0 in order, of frame bit 7 reversed.
+    uint8_t     mask = 0; // Frame bits in use.
+  };
+
+  // make_run checks if the frame byte i is a shifted, maybe reversed, source row.
+  static constexpr Run make_run(std::size_t i) noexcept {
+    Run         in_order{1, Y * Z, 0, 0};
+    Run         backward{2, Y * Z, 0, 0};
+
+    for (std::size_t k = 0; k < 8; k++) {
+      const Source& s = plan[i][k];
+
+      if (s.row == Y * Z) {
+        continue;
+      }
+      if (in_order.mask == 0) {
+        in_order.row = backward.row = s.row;
+        in_order.base = s.bit - k;
+        backward.base = s.bit + k - 7;
+        in_order.kind = s.bit >= k ? in_order.kind : 0;
+        backward.kind = s.bit + k >= 7 ? backward.kind : 0;
+      }
+      if (s.row != in_order.row || s.bit != in_order.base + k) {
+        in_order.kind = 0;
+      }
+      if (s.row != backward.row || s.bit + k != backward.base + 7) {
+        backward.kind = 0;
+      }
+      in_order.mask |= 1 << k;
+      backward.mask |= 1 << k;
+    }
+    if (in_order.mask == 0 || in_order.kind) {
+      return in_order;
+    }
+    return backward.kind ? backward : Run{0, 0, 0, in_order.mask};
+  }
+
+  template <std::size_t... I>
+  static constexpr std::array<Run, sizeof...(I)> make_runs(std::index_sequence<I...>) noexcept {
+    return {make_run(I)...};
+  }
+
+  static constexpr std::array<Run, Y * anode_bytes> runs = make_runs(std::make_index_sequence<Y * anode_bytes>());
+
+  // Bit reversal of each byte.
+  static constexpr std::array<uint8_t, 256> make_reversed() noexcept {
+    std::array<uint8_t, 256> table{};
+
+    for (std::size_t b = 0; b < 256; b++) {
+      for (std::size_t k = 0; k < 8; k++) {
+        table[b] |= ((b >> k) & 1) << (7 - k);
+      }
+    }
+    return table;
+  }
+
+  static constexpr std::array<uint8_t, 256> reversed = make_reversed();
+
+  template <std::size_t I, std::size_t K>
+  static uint8_t bit(const typename CubeT::word_type* rows) noexcept {
+    constexpr Source s = plan[I][K];
+
+    if constexpr (s.row == Y * Z) {
+      return 0;
+    } else {
+      return uint8_t((rows[s.row] >> s.bit) & 1) << K;
+    }
+  }
+
+  template <std::size_t I, std::size_t... K>
+  static uint8_t anode_byte(const typename CubeT::word_type* rows, std::index_sequence<K...>) noexcept {
+    constexpr Run r = runs[I];
+
+    if constexpr (r.mask == 0) {
+      return 0;
+    } else if constexpr (r.kind == 1) {
+      return uint8_t(rows[r.row] >> r.base) & r.mask;
+    } else if constexpr (r.kind == 2) {
+      return reversed[uint8_t(rows[r.row] >> r.base)] & r.mask;
+    } else {
+      return (bit<I, K>(rows) | ...);
+    }
+  }
+
+  // cathode_byte is the constant cathode byte c of the word of layer i.
+  static constexpr uint8_t cathode_byte(std::size_t i, std::size_t c) noexcept {
+    return i / 8 == c ? uint8_t(1 << i % 8) : 0;
+  }
+
+  template <std::size_t... I>
+  static void pack_bytes(const typename CubeT::word_type* rows, frame_type& tx, std::index_sequence<I...>) noexcept {
+    ((tx[I / anode_bytes][cathode_bytes + I % anode_bytes] = anode_byte<I>(rows, std::make_index_sequence<8>())), ...);
+    pack_cathodes(tx, std::make_index_sequence<Y * cathode_bytes>());
+  }
+
+  template <std::size_t... I>
+  static void pack_cathodes(frame_type& tx, std::index_sequence<I...>) noexcept {
+    ((tx[I / cathode_bytes][I % cathode_bytes] = cathode_byte(I / cathode_bytes, I % cathode_bytes)), ...);
+  }
+};
+
+} // namespace cube
+
+#endif /* !__CUBE_HPP__ */
@@ -38,11 +38,10 @@ void setup_cube();
 int renderCube(spi_handler hdlr, uint8_t cube[8][8]);
 int loop(spi_handler hdlr, uint8_t cube[8][8]);
 
+// transfer sends tx, half-duplex: nothing is read back from the shift registers.
 int                             transfer(spi_handler hdlr, uint8_t tx[], uint64_t len) {
-  uint8_t*                      rx = malloc(sizeof(uint8_t) * len); // TODO: See if we can get rid of this one.
   struct spi_ioc_transfer       tr = {
     .tx_buf        = (unsigned long)tx,
-    .rx_buf        = (unsigned long)rx,
     .len           = len,
     .delay_usecs   = hdlr.config.delay,
     .speed_hz      = hdlr.config.speed,
@@ -25,6 +25,9 @@ var (
 	zMap = [][]int{{1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}}
 )
 
+// Refresh rate of the whole cube, in Hz.
+const refreshRate = 500
+
 func main() {
 	platform := raspi.NewAdaptor()
 	adaptor := spi595.NewAdaptor(platform,
@@ -53,17 +56,30 @@ func main() {
 	)
 	robot.AddEvent("stop")
 
+	// Closed when the refresh loop stops on its own, on a SPI error.
+	refreshDone := make(chan struct{})
+
 	robot.Work = func() {
-		ticker1 := gobot.Every(5*time.Microsecond, func() {
-			driver.Draw()
-		})
+		if err := driver.StartRefresh(refreshRate); err != nil {
+			log.Fatalf("StartRefresh error: %s\n", err)
+		}
+		go func() {
+			<-driver.RefreshDone()
+			close(refreshDone)
+		}()
 		i := 0
 		ticker2 := gobot.Every(10*time.Second, func() {
 			i %= len(sceneCtors)
 			driver.Scene(sceneCtors[i]())
 			i++
 		})
-		if err := robot.On(robot.Event("stop"), func(interface{}) { ticker1.Stop(); ticker2.Stop() }); err != nil {
+		if err := robot.On(robot.Event("stop"), func(interface{}) {
+			ticker2.Stop()
+			if err := driver.StopRefresh(); err != nil {
+				log.Printf("refresh error: %s\n", err)
+			}
+			log.Printf("refresh: %s\n", driver.RefreshStats())
+		}); err != nil {
 			log.Fatalf("On stop hook setup error: %s\n", err)
 		}
 	}
@@ -73,10 +89,14 @@ func main() {
 		log.Fatalf("robot.Start error: %s\n", err)
 	}
 
-	// Handle ctrl-c.
+	// Handle ctrl-c, or the refresh loop giving up.
 	c := make(chan os.Signal, 1)
 	signal.Notify(c, os.Interrupt)
-	<-c
+	select {
+	case <-c:
+	case <-refreshDone:
+		log.Printf("refresh stopped\n")
+	}
 	signal.Stop(c)
 	close(c)
 
@@ -1,11 +1,18 @@
 package cube
 
+import (
+	"encoding/binary"
+	"unsafe"
+)
+
 // Element represent the X axis. Z and Y are from the 2d array state.
 type Element byte
 
 // Cube is the in-memory representation of the c.
+// The state is flat and contiguous: the X row of y, z is at (YLen-1-y)*ZLen + ZLen-1-z,
+// so each Y layer is ZLen consecutive rows. Copies of a Cube share the same state.
 type Cube struct {
-	state [][]Element // Actual state.
+	state []Element // Actual state.
 	XLen  int
 	YLen  int
 	ZLen  int
@@ -13,48 +20,58 @@ type Cube struct {
 
 // New instantiate a simple cube of the given size.
 func New(size int) Cube {
-	state := make([][]Element, size)
-	for i := 0; i < size; i++ {
-		state[i] = make([]Element, size)
-	}
-	return Cube{
-		state: state,
-		XLen:  size,
-		YLen:  size,
-		ZLen:  size,
-	}
+	return NewCustom(size, size, size)
 }
 
 // NewCustom instantiate a rectangular prism.
 func NewCustom(xLen, yLen, zLen int) Cube {
-	state := make([][]Element, yLen)
-	for i := 0; i < yLen; i++ {
-		state[i] = make([]Element, zLen)
-	}
 	return Cube{
-		state: state,
+		state: make([]Element, yLen*zLen),
 		XLen:  xLen,
 		YLen:  yLen,
 		ZLen:  zLen,
 	}
 }
 
+// row returns the index of the X row of y, z in the state.
+func (c Cube) row(y, z int) int {
+	return (c.YLen-1-y)*c.ZLen + c.ZLen - 1 - z
+}
+
 // SetVoxel turns on the given point in the cube.
 func (c Cube) SetVoxel(x, y, z int) {
-	c.state[c.YLen-1-y][c.ZLen-1-z] |= 0x01 << uint(x)
+	c.state[c.row(y, z)] |= 0x01 << uint(x)
 }
 
 // GetVoxel returns the value of the requested point in the cube.
 func (c Cube) GetVoxel(x, y, z int) bool {
-	return (c.state[c.YLen-1-y][c.ZLen-1-z] & (0x01 << uint(x))) == (0x01 << uint(x))
+	return (c.state[c.row(y, z)] & (0x01 << uint(x))) == (0x01 << uint(x))
+}
+
+// Row returns the X row of the cube at y, z, bit x set for each voxel on.
+func (c Cube) Row(y, z int) Element {
+	return c.state[c.row(y, z)]
+}
+
+// SetLayer replaces the Y layer y with the bitboard, byte i holding the X row of
+// z = ZLen-1-i as the C cube_layer_t does. For cubes up to 8 voxels on Z.
+func (c Cube) SetLayer(y int, layer uint64) {
+	full := Element(1<<uint(c.XLen) - 1)
+	rows := c.state[(c.YLen-1-y)*c.ZLen : (c.YLen-y)*c.ZLen]
+	for i := range rows {
+		rows[i] = Element(layer>>(8*uint(i))) & full
+	}
+}
+
+// Copy sets the cube to the state of src, of the same size.
+func (c Cube) Copy(src Cube) {
+	copy(c.state, src.state)
 }
 
 // Clear turns off the whole cube,
 func (c Cube) Clear() {
-	for y, line := range c.state {
-		for z := range line {
-			c.state[y][z] = 0x00
-		}
+	for i := range c.state {
+		c.state[i] = 0x00
 	}
 }
 
@@ -70,19 +87,24 @@ const (
 
 // SetPlane turns on the Nth plane following then given axis.
 func (c Cube) SetPlane(axis Axis, n int) {
-	for j := 0; j < 8; j++ {
-		for k := 0; k < 8; k++ {
-			switch axis {
-			case AxisX:
-				c.SetVoxel(n, j, k)
-			case AxisY:
-				c.SetVoxel(j, n, k)
-			case AxisZ:
-				c.SetVoxel(j, k, n)
-			default:
-				panic("invalid axis")
-			}
+	full := Element(1<<uint(c.XLen) - 1)
+
+	switch axis {
+	case AxisX:
+		for i := range c.state {
+			c.state[i] |= 0x01 << uint(n)
 		}
+	case AxisY:
+		layer := c.state[(c.YLen-1-n)*c.ZLen : (c.YLen-n)*c.ZLen]
+		for i := range layer {
+			layer[i] |= full
+		}
+	case AxisZ:
+		for i := c.ZLen - 1 - n; i < len(c.state); i += c.ZLen {
+			c.state[i] |= full
+		}
+	default:
+		panic("invalid axis")
 	}
 }
 
@@ -112,57 +134,90 @@ var (
 )
 
 // Shift translates the cube following the given direction.
+// Y is a move of whole layers, Z of rows within the layers, X a shift of each row.
 func (c Cube) Shift(dir AxisVector) {
 	switch dir {
 	case PosX:
-		for y := 0; y < c.YLen; y++ {
-			for z := 0; z < c.ZLen; z++ {
-				c.state[y][z] <<= 1
-			}
-		}
+		c.shiftX(true)
 	case NegX:
-		for y := 0; y < c.YLen; y++ {
-			for z := 0; z < c.ZLen; z++ {
-				c.state[y][z] >>= 1
-			}
-		}
+		c.shiftX(false)
 	case PosY:
-		for y := 1; y < c.YLen; y++ {
-			for z := 0; z < c.ZLen; z++ {
-				c.state[y-1][z] = c.state[y][z]
-			}
-		}
-		for i := 0; i < c.ZLen; i++ {
-			c.state[c.YLen-1][i] = 0
-		}
+		copy(c.state, c.state[c.ZLen:])
+		clearRows(c.state[len(c.state)-c.ZLen:])
 	case NegY:
-		for y := c.YLen - 1; y > 0; y-- {
-			for z := 0; z < c.ZLen; z++ {
-				c.state[y][z] = c.state[y-1][z]
-			}
-		}
-		for i := 0; i < c.ZLen; i++ {
-			c.state[0][i] = 0
-		}
+		copy(c.state[c.ZLen:], c.state)
+		clearRows(c.state[:c.ZLen])
 	case PosZ:
-		for y := 0; y < c.YLen; y++ {
-			for z := 1; z < c.ZLen; z++ {
-				c.state[y][z-1] = c.state[y][z]
-			}
+		c.shiftZ(true)
+	case NegZ:
+		c.shiftZ(false)
+	default:
+		panic("invalid direction")
+	}
+}
+
+// words returns the rows as bytes, up to the last full 64 bits word.
+func (c Cube) words() []byte {
+	if len(c.state) < 8 {
+		return nil
+	}
+	return unsafe.Slice((*byte)(unsafe.Pointer(&c.state[0])), len(c.state)&^7)
+}
+
+// shiftX shifts each row, 8 rows at a time as a 64 bits word, the remaining ones one by one.
+func (c Cube) shiftX(pos bool) {
+	words := c.words()
+
+	for i := 0; i < len(words); i += 8 {
+		w := binary.LittleEndian.Uint64(words[i:])
+		if pos {
+			w = w << 1 & 0xFEFEFEFEFEFEFEFE
+		} else {
+			w = w >> 1 & 0x7F7F7F7F7F7F7F7F
 		}
-		for i := 0; i < c.YLen; i++ {
-			c.state[i][c.ZLen-1] = 0
+		binary.LittleEndian.PutUint64(words[i:], w)
+	}
+	for i := len(words); i < len(c.state); i++ {
+		if pos {
+			c.state[i] <<= 1
+		} else {
+			c.state[i] >>= 1
 		}
-	case NegZ:
-		for y := 0; y < c.YLen; y++ {
-			for z := c.ZLen - 1; z > 0; z-- {
-				c.state[y][z] = c.state[y][z-1]
+	}
+}
+
+// shiftZ moves the rows of each Y layer. 8 deep layers are a single 64 bits word, shifted
+// by a row towards the lower addresses for PosZ.
+func (c Cube) shiftZ(pos bool) {
+	if c.ZLen == 8 {
+		words := c.words()
+		for i := 0; i < len(words); i += 8 {
+			w := binary.LittleEndian.Uint64(words[i:])
+			if pos {
+				w >>= 8
+			} else {
+				w <<= 8
 			}
+			binary.LittleEndian.PutUint64(words[i:], w)
 		}
-		for i := 0; i < c.YLen; i++ {
-			c.state[c.YLen][0] = 0
+		return
+	}
+
+	for i := 0; i < len(c.state); i += c.ZLen {
+		layer := c.state[i : i+c.ZLen]
+		if pos {
+			copy(layer, layer[1:])
+			layer[c.ZLen-1] = 0
+		} else {
+			copy(layer[1:], layer)
+			layer[0] = 0
 		}
-	default:
-		panic("invalid direction")
+	}
+}
+
+// clearRows turns off the given rows.
+func clearRows(rows []Element) {
+	for i := range rows {
+		rows[i] = 0x00
 	}
 }
@@ -0,0 +1,161 @@
+package cube
+
+import (
+	"math/rand"
+	"testing"
+)
+
+// Sizes checked: the 8x8x8 cube on the 64 bits word paths, and a prism on the row by row ones.
+var testSizes = [][3]int{{8, 8, 8}, {8, 5, 7}}
+
+var testDirs = []AxisVector{PosX, NegX, PosY, NegY, PosZ, NegZ}
+
+// model is the cube as one bool per voxel, indexed [x][y][z].
+type model [][][]bool
+
+// newModel returns the model of c.
+func newModel(c Cube) model {
+	m := make(model, c.XLen)
+	for x := range m {
+		m[x] = make([][]bool, c.YLen)
+		for y := range m[x] {
+			m[x][y] = make([]bool, c.ZLen)
+			for z := range m[x][y] {
+				m[x][y][z] = c.GetVoxel(x, y, z)
+			}
+		}
+	}
+	return m
+}
+
+// get returns the voxel at v, off outside of the model.
+func (m model) get(v [3]int) bool {
+	if v[0] < 0 || v[0] >= len(m) || v[1] < 0 || v[1] >= len(m[0]) || v[2] < 0 || v[2] >= len(m[0][0]) {
+		return false
+	}
+	return m[v[0]][v[1]][v[2]]
+}
+
+// shift moves each voxel by one along dir, a positive direction growing the coordinate.
+func (m model) shift(dir AxisVector) model {
+	step := 1
+	if dir.Direction == Neg {
+		step = -1
+	}
+	out := make(model, len(m))
+	for x := range m {
+		out[x] = make([][]bool, len(m[x]))
+		for y := range m[x] {
+			out[x][y] = make([]bool, len(m[x][y]))
+			for z := range m[x][y] {
+				src := [3]int{x, y, z}
+				src[dir.Axis] -= step
+				out[x][y][z] = m.get(src)
+			}
+		}
+	}
+	return out
+}
+
+// setPlane turns on the voxels of the nth plane of the axis.
+func (m model) setPlane(axis Axis, n int) {
+	for x := range m {
+		for y := range m[x] {
+			for z := range m[x][y] {
+				if [3]int{x, y, z}[axis] == n {
+					m[x][y][z] = true
+				}
+			}
+		}
+	}
+}
+
+// check fails the test on the first voxel of c not matching the model.
+func (m model) check(t *testing.T, c Cube, what string) {
+	t.Helper()
+	for x := range m {
+		for y := range m[x] {
+			for z := range m[x][y] {
+				if c.GetVoxel(x, y, z) != m[x][y][z] {
+					t.Fatalf("%s: voxel %d %d %d is %v, expected %v", what, x, y, z, !m[x][y][z], m[x][y][z])
+				}
+			}
+		}
+	}
+}
+
+// randomCube returns a cube of the given size with about half of the voxels on.
+func randomCube(rnd *rand.Rand, size [3]int) Cube {
+	c := NewCustom(size[0], size[1], size[2])
+	for x := 0; x < c.XLen; x++ {
+		for y := 0; y < c.YLen; y++ {
+			for z := 0; z < c.ZLen; z++ {
+				if rnd.Intn(2) == 0 {
+					c.SetVoxel(x, y, z)
+				}
+			}
+		}
+	}
+	return c
+}
+
+// TestShift checks repeated shifts in each direction against the model, until the cube is empty.
+func TestShift(t *testing.T) {
+	rnd := rand.New(rand.NewSource(1))
+
+	for _, size := range testSizes {
+		for _, dir := range testDirs {
+			for i := 0; i < 16; i++ {
+				c := randomCube(rnd, size)
+				m := newModel(c)
+				for s := 0; s <= size[dir.Axis]; s++ {
+					c.Shift(dir)
+					m = m.shift(dir)
+					m.check(t, c, "shift")
+				}
+			}
+		}
+	}
+}
+
+// TestSetPlane checks each plane of each axis against the model, on random cubes.
+func TestSetPlane(t *testing.T) {
+	rnd := rand.New(rand.NewSource(1))
+
+	for _, size := range testSizes {
+		for axis := AxisX; axis <= AxisZ; axis++ {
+			for n := 0; n < size[axis]; n++ {
+				c := randomCube(rnd, size)
+				m := newModel(c)
+				c.SetPlane(axis, n)
+				m.setPlane(axis, n)
+				m.check(t, c, "set plane")
+			}
+		}
+	}
+}
+
+func benchmarkShift(b *testing.B, dir AxisVector) {
+	c := randomCube(rand.New(rand.NewSource(1)), testSizes[0])
+
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		c.Shift(dir)
+	}
+}
+
+func BenchmarkShiftPosX(b *testing.B) { benchmarkShift(b, PosX) }
+func BenchmarkShiftNegX(b *testing.B) { benchmarkShift(b, NegX) }
+func BenchmarkShiftPosY(b *testing.B) { benchmarkShift(b, PosY) }
+func BenchmarkShiftNegY(b *testing.B) { benchmarkShift(b, NegY) }
+func BenchmarkShiftPosZ(b *testing.B) { benchmarkShift(b, PosZ) }
+func BenchmarkShiftNegZ(b *testing.B) { benchmarkShift(b, NegZ) }
+
+func BenchmarkSetPlane(b *testing.B) {
+	c := New(8)
+
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		c.SetPlane(Axis(i%3), i%8)
+	}
+}
@@ -14,19 +14,25 @@ type Scene struct {
 	loading        bool
 	planeDirection cube.AxisVector
 	planePosition  int
+	rand           *rand.Rand
 }
 
-// New instantiate a new scene.
+// New instantiate a new scene, seeded from the time.
 func New() scenes.Scene {
-	return &Scene{loading: true}
+	return NewSeeded(time.Now().UnixNano())
+}
+
+// NewSeeded instantiate a new scene stepping the same for the same seed.
+func NewSeeded(seed int64) scenes.Scene {
+	return &Scene{loading: true, rand: rand.New(rand.NewSource(seed))}
 }
 
 // Step implements the scenes.Scene interface.
 func (s *Scene) Step(c cube.Cube) time.Duration {
 	if s.loading {
 		c.Clear()
-		axis := cube.Axis(rand.Int() % 3)
-		s.planePosition = (rand.Int()) % 2 * 7
+		axis := cube.Axis(s.rand.Intn(3))
+		s.planePosition = s.rand.Intn(2) * 7
 		c.SetPlane(axis, s.planePosition)
 		switch axis {
 		case cube.AxisX:
@@ -8,15 +8,25 @@ import (
 	"github.com/geplo/cube/scenes"
 )
 
+// Density of the drops on the top layer, 2 drops per layer on average.
+const density = 8
+
 // Scene holds the state.
 type Scene struct {
 	loading bool
+	rand    *rand.Rand
 }
 
-// New instantiate a new scene.
+// New instantiate a new scene, seeded from the time.
 func New() scenes.Scene {
+	return NewSeeded(time.Now().UnixNano())
+}
+
+// NewSeeded instantiate a new scene stepping the same for the same seed.
+func NewSeeded(seed int64) scenes.Scene {
 	return &Scene{
 		loading: true,
+		rand:    rand.New(rand.NewSource(seed)),
 	}
 }
 
@@ -27,10 +37,7 @@ func (s *Scene) Step(c cube.Cube) time.Duration {
 		s.loading = false
 	}
 	c.Shift(cube.NegY)
-	numDrops := rand.Int() % 5
-	for i := 0; i < numDrops; i++ {
-		c.SetVoxel(rand.Int()%c.XLen, c.YLen-1, rand.Int()%c.ZLen)
-	}
+	c.SetLayer(c.YLen-1, scenes.Mask(s.rand, density))
 
 	return 60 * time.Millisecond
 }
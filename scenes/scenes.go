@@ -1,6 +1,8 @@
 package scenes
 
 import (
+	"math/bits"
+	"math/rand"
 	"time"
 
 	"github.com/geplo/cube"
@@ -10,3 +12,28 @@ import (
 type Scene interface {
 	Step(cube.Cube) time.Duration
 }
+
+// DensityOne is the density of Mask with all the bits set.
+const DensityOne = 256
+
+// Mask returns 64 random bits, each set with probability density / DensityOne.
+// Going through the bits of the density from the lowest set one, OR-ing a random
+// word in for a 1 and AND-ing one for a 0 halves the probability of a bit and adds
+// the density bit as its new half, so it takes at most 8 random words.
+func Mask(r *rand.Rand, density int) uint64 {
+	if density <= 0 {
+		return 0
+	}
+	if density >= DensityOne {
+		return ^uint64(0)
+	}
+	var mask uint64
+	for bit := bits.TrailingZeros(uint(density)); bit < 8; bit++ {
+		if w := r.Uint64(); density>>uint(bit)&1 == 1 {
+			mask |= w
+		} else {
+			mask &= w
+		}
+	}
+	return mask
+}
@@ -1,6 +1,8 @@
 package spi595
 
 import (
+	"math/bits"
+
 	"github.com/geplo/cube"
 	"github.com/pkg/errors"
 	"gobot.io/x/gobot"
@@ -17,6 +19,12 @@ type Adaptor struct {
 
 	// SPI handler.
 	connection spi.Connection
+
+	// Render buffers, built for the size of the first cube rendered so the render path doesn't allocate.
+	xLen, yLen, zLen int
+	perm             []uint16       // Hardware voxel of each cube voxel, both as ((y*zLen)+z)*8 + x.
+	mapped           []cube.Element // Mapped cube, X row of each y, z at y*zLen + z.
+	tx               []byte         // SPI word, 1 cathode, zLen anodes.
 }
 
 // NewAdaptor .
@@ -76,46 +84,70 @@ func (a *Adaptor) Finalize() error {
 	return a.connection.Close()
 }
 
-func (a *Adaptor) mapCube(src cube.Cube) cube.Cube {
-	dst := cube.NewCustom(src.XLen, src.YLen, src.ZLen)
+// compile builds the render buffers and the voxel permutation from the hardware mapping,
+// once for a given cube size.
+// TODO: Handle XLen > 8.
+func (a *Adaptor) compile(c cube.Cube) {
+	if a.perm != nil && a.xLen == c.XLen && a.yLen == c.YLen && a.zLen == c.ZLen {
+		return
+	}
+	a.xLen, a.yLen, a.zLen = c.XLen, c.YLen, c.ZLen
+	a.perm = make([]uint16, c.YLen*c.ZLen*8)
+	a.mapped = make([]cube.Element, c.YLen*c.ZLen)
+	a.tx = make([]byte, 1+c.ZLen)
 
 	// For each point of the cube, map x/y/z to match the defined hardware wiring.
-	for x := 0; x < dst.XLen; x++ {
-		for y := 0; y < dst.YLen; y++ {
-			for z := 0; z < dst.ZLen; z++ {
-				if src.GetVoxel(x, y, z) {
-					dst.SetVoxel(a.XMap(z, x), a.YMap(x, y), a.ZMap(x, z))
-				}
+	for x := 0; x < c.XLen; x++ {
+		for y := 0; y < c.YLen; y++ {
+			for z := 0; z < c.ZLen; z++ {
+				a.perm[(y*c.ZLen+z)*8+x] = uint16((a.YMap(x, y)*c.ZLen+a.ZMap(x, z))*8 + a.XMap(z, x))
 			}
 		}
 	}
+}
+
+// mapCube maps the cube to the hardware in the mapped buffer, walking only the voxels on.
+func (a *Adaptor) mapCube(src cube.Cube) {
+	a.compile(src)
 
-	return dst
+	for i := range a.mapped {
+		a.mapped[i] = 0
+	}
+	// Bits past XLen, e.g. left by a shift, have no voxel to map to.
+	mask := uint8(1<<uint(src.XLen) - 1)
+	for y := 0; y < src.YLen; y++ {
+		for z := 0; z < src.ZLen; z++ {
+			perm := a.perm[(y*src.ZLen+z)*8:]
+			for row := uint8(src.Row(y, z)) & mask; row != 0; row &= row - 1 {
+				dst := perm[bits.TrailingZeros8(row)]
+				a.mapped[dst>>3] |= 0x01 << (dst & 0x07)
+			}
+		}
+	}
 }
 
 func (a *Adaptor) renderCube(c cube.Cube) error {
-	c = a.mapCube(c)
+	a.mapCube(c)
 
-	// We send one plane at a time to SPI. 1 cathode, ZLen anones.
-	// TODO: Handle XLen > 8.
-	tx := make([]byte, 1+c.ZLen)
-
-	// The first "word" is the cathode layer, which is the Y axis.
+	// We send one plane at a time to SPI.
 	for y := 0; y < c.YLen; y++ {
-		tx[0] = 0x01 << uint(y)
-
-		for z := 0; z < c.ZLen; z++ {
-			tx[z+1] = 0
-			for x := 0; x < c.XLen; x++ {
-				if c.GetVoxel(x, y, z) {
-					tx[z+1] |= 0x01 << uint(x)
-				}
-			}
-		}
-		if err := a.connection.Tx(tx, nil); err != nil {
-			return errors.Wrap(err, "spi.Tx")
+		if err := a.renderLayer(y); err != nil {
+			return err
 		}
 	}
 
 	return nil
 }
+
+// renderLayer sends a plane of the cube last mapped to SPI. 1 cathode, ZLen anones.
+// The first "word" is the cathode layer, which is the Y axis.
+func (a *Adaptor) renderLayer(y int) error {
+	a.tx[0] = 0x01 << uint(y)
+	for z := 0; z < a.zLen; z++ {
+		a.tx[z+1] = byte(a.mapped[y*a.zLen+z])
+	}
+	if err := a.connection.Tx(a.tx, nil); err != nil {
+		return errors.Wrap(err, "spi.Tx")
+	}
+	return nil
+}
@@ -0,0 +1,145 @@
+package spi595
+
+import (
+	"errors"
+	"sync"
+	"testing"
+
+	"github.com/geplo/cube"
+	"gobot.io/x/gobot/drivers/spi"
+)
+
+// Wiring of the cube in cmd/cube.
+var (
+	testXMap = [][]int{{0, 1, 2, 3, 4, 5, 6, 7}, {7, 6, 5, 4, 3, 2, 1, 0}, {0, 1, 2, 3, 4, 5, 6, 7}, {7, 6, 5, 4, 3, 2, 1, 0}, {0, 1, 2, 3, 4, 5, 6, 7}, {7, 6, 5, 4, 3, 2, 1, 0}, {0, 1, 2, 3, 4, 5, 6, 7}, {7, 6, 5, 4, 3, 2, 1, 0}}
+	testYMap = [][]int{{0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7}}
+	testZMap = [][]int{{1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}, {1, 0, 3, 2, 5, 4, 7, 6}}
+)
+
+// testConn is a SPI connection keeping the words sent, when recording, or failing when err is set.
+type testConn struct {
+	spi.Connection
+	sync.Mutex
+	record bool
+	words  [][]byte
+	err    error
+}
+
+func (c *testConn) Tx(w, r []byte) error {
+	c.Lock()
+	defer c.Unlock()
+	if c.record {
+		c.words = append(c.words, append([]byte(nil), w...))
+	}
+	return c.err
+}
+
+func (c *testConn) Close() error { return nil }
+
+// newTestAdaptor returns an adaptor with the cmd/cube wiring, connected to conn.
+func newTestAdaptor(conn *testConn) *Adaptor {
+	a := NewAdaptor(nil, WithXMap(testXMap), WithYMap(testYMap), WithZMap(testZMap))
+	a.connection = conn
+	return a
+}
+
+// newTestCube returns a cube with scattered voxels and a full plane.
+func newTestCube() cube.Cube {
+	c := cube.New(8)
+	for i := 0; i < 200; i++ {
+		c.SetVoxel(i*5%8, i*3%8, i*7%8)
+	}
+	c.SetPlane(cube.AxisY, 2)
+	return c
+}
+
+// TestRenderCube checks the words sent against a voxel by voxel mapping.
+func TestRenderCube(t *testing.T) {
+	conn := &testConn{record: true}
+	a := newTestAdaptor(conn)
+	c := newTestCube()
+
+	if err := a.renderCube(c); err != nil {
+		t.Fatal(err)
+	}
+	if len(conn.words) != c.YLen {
+		t.Fatalf("%d words sent, expected %d", len(conn.words), c.YLen)
+	}
+	for y := 0; y < c.YLen; y++ {
+		want := make([]byte, 1+c.ZLen)
+		want[0] = 0x01 << uint(y)
+		for vx := 0; vx < c.XLen; vx++ {
+			for vy := 0; vy < c.YLen; vy++ {
+				for vz := 0; vz < c.ZLen; vz++ {
+					if c.GetVoxel(vx, vy, vz) && a.YMap(vx, vy) == y {
+						want[1+a.ZMap(vx, vz)] |= 0x01 << uint(a.XMap(vz, vx))
+					}
+				}
+			}
+		}
+		if string(conn.words[y]) != string(want) {
+			t.Errorf("layer %d: got %v, expected %v", y, conn.words[y], want)
+		}
+	}
+}
+
+// TestMapCubeNarrow checks the bits past XLen of a narrow cube don't light any voxel.
+func TestMapCubeNarrow(t *testing.T) {
+	a := newTestAdaptor(&testConn{})
+	c := cube.NewCustom(4, 8, 8)
+
+	// Shifting the last X plane leaves its bits past XLen.
+	c.SetPlane(cube.AxisX, c.XLen-1)
+	c.Shift(cube.PosX)
+	a.mapCube(c)
+	for i, row := range a.mapped {
+		if row != 0 {
+			t.Fatalf("mapped row %d is %#x, expected 0", i, row)
+		}
+	}
+}
+
+// TestRenderCubeAllocs checks the render path doesn't allocate once compiled.
+func TestRenderCubeAllocs(t *testing.T) {
+	a := newTestAdaptor(&testConn{})
+	c := newTestCube()
+
+	if n := testing.AllocsPerRun(100, func() {
+		if err := a.renderCube(c); err != nil {
+			t.Fatal(err)
+		}
+	}); n != 0 {
+		t.Fatalf("%v allocations per render, expected 0", n)
+	}
+}
+
+// TestRenderCubeError checks the SPI error is returned.
+func TestRenderCubeError(t *testing.T) {
+	a := newTestAdaptor(&testConn{err: errors.New("tx")})
+
+	if err := a.renderCube(newTestCube()); err == nil {
+		t.Fatal("expected an error")
+	}
+}
+
+func BenchmarkRenderCube(b *testing.B) {
+	a := newTestAdaptor(&testConn{})
+	c := newTestCube()
+
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		if err := a.renderCube(c); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+func BenchmarkMapCube(b *testing.B) {
+	a := newTestAdaptor(&testConn{})
+	c := newTestCube()
+
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		a.mapCube(c)
+	}
+}
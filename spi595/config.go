@@ -62,7 +62,7 @@ func (c config) YMap(x, y int) int {
 	if c.yMap == nil {
 		return y
 	}
-	return c.xMap[x][y]
+	return c.yMap[x][y]
 }
 
 // ZMap .
@@ -1,8 +1,8 @@
 package spi595
 
 import (
-	"math/rand"
 	"sync"
+	"sync/atomic"
 	"time"
 
 	"github.com/geplo/cube"
@@ -19,6 +19,10 @@ const (
 )
 
 // Driver .
+//
+// The scene side (Step, Scene, Halt) is serialized by the mutex and draws in Cube, then
+// publishes it to Draw through a triple buffer. Draw renders the latest published frame
+// without locking, it must be called from a single goroutine.
 type Driver struct {
 	sync.Mutex
 	name       string
@@ -28,8 +32,12 @@ type Driver struct {
 	gobot.Commander
 
 	cube.Cube
-	scene scenes.Scene
-	next  time.Time
+	scene  scenes.Scene
+	next   int64 // Time of the next step, in unix nsec, accessed atomically.
+	frames *frames
+
+	switched chan struct{} // Wakes up the scene goroutine of the refresh loop.
+	refresh  *refresh
 }
 
 // NewDriver .
@@ -40,8 +48,11 @@ func NewDriver(a *Adaptor, cube cube.Cube, scene scenes.Scene) *Driver {
 		Eventer:    gobot.NewEventer(),
 		Commander:  gobot.NewCommander(),
 
-		Cube:  cube,
-		scene: scene,
+		Cube:   cube,
+		scene:  scene,
+		frames: newFrames(cube),
+
+		switched: make(chan struct{}, 1),
 	}
 	d.AddEvent(Step)
 	d.AddCommand(Step, func(map[string]interface{}) interface{} { return d.Step() })
@@ -54,7 +65,8 @@ func (d *Driver) Step() time.Duration {
 	d.Lock()
 	defer d.Unlock()
 	next := d.scene.Step(d.Cube)
-	d.next = time.Now().Add(next)
+	d.frames.publish(d.Cube)
+	atomic.StoreInt64(&d.next, time.Now().Add(next).UnixNano())
 	return next
 }
 
@@ -63,7 +75,11 @@ func (d *Driver) Scene(scene scenes.Scene) {
 	d.Lock()
 	defer d.Unlock()
 	d.scene = scene
-	d.next = time.Now()
+	atomic.StoreInt64(&d.next, time.Now().UnixNano())
+	select {
+	case d.switched <- struct{}{}:
+	default:
+	}
 }
 
 // Connection returns the Connection of the device.
@@ -73,8 +89,6 @@ func (d *Driver) Connection() gobot.Connection { return d.connection }
 // Start initializes the driver.
 // Implements gobot.Driver / gobot.Device interface.
 func (d *Driver) Start() (err error) {
-	// Seed the random generator.
-	rand.Seed(time.Now().UnixNano())
 	println("driver start")
 	return nil
 }
@@ -83,7 +97,13 @@ func (d *Driver) Start() (err error) {
 // Implements gobot.Driver / gobot.Device interface.
 func (d *Driver) Halt() error {
 	println("driver stop")
+	if err := d.StopRefresh(); err != nil {
+		return errors.Wrap(err, "refresh")
+	}
+	d.Lock()
+	defer d.Unlock()
 	d.Cube.Clear()
+	d.frames.publish(d.Cube)
 	return nil
 }
 
@@ -95,16 +115,22 @@ func (d *Driver) Name() string { return d.name }
 // Implements gobot.Driver / gobot.Device interface.
 func (d *Driver) SetName(n string) { d.name = n }
 
-// Draw displays the cube.
+// latest returns the latest frame published.
+func (d *Driver) latest() cube.Cube {
+	c, _ := d.frames.latest()
+	return c
+}
+
+// Draw displays the latest frame, stepping the scene first when due.
 func (d *Driver) Draw() error {
 	start := time.Now()
 
-	if d.next.Before(start) {
+	if atomic.LoadInt64(&d.next) < start.UnixNano() {
 		d.Publish(d.Event(Step), start)
-		d.next = start.Add(d.scene.Step(d.Cube))
+		d.Step()
 	}
 
-	if err := d.connection.renderCube(d.Cube); err != nil {
+	if err := d.connection.renderCube(d.latest()); err != nil {
 		return errors.Wrap(err, "renderCube")
 	}
 	return nil
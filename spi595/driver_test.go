@@ -0,0 +1,181 @@
+package spi595
+
+import (
+	"errors"
+	"sync"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	"github.com/geplo/cube"
+)
+
+// flipScene turns the whole cube on and off on each step, so a torn frame mixes full and empty rows.
+type flipScene struct {
+	on bool
+}
+
+func (s *flipScene) Step(c cube.Cube) time.Duration {
+	s.on = !s.on
+	c.Clear()
+	if s.on {
+		for x := 0; x < c.XLen; x++ {
+			c.SetPlane(cube.AxisX, x)
+		}
+	}
+	return 100 * time.Microsecond
+}
+
+// newTestDriver returns a driver of an 8x8x8 cube rendered to a test connection.
+func newTestDriver() *Driver {
+	return NewDriver(newTestAdaptor(&testConn{}), cube.New(8), &flipScene{})
+}
+
+// switchScenes switches the scene of the driver until stop is closed.
+func switchScenes(d *Driver, stop <-chan struct{}, wg *sync.WaitGroup) {
+	defer wg.Done()
+	for i := 0; ; i++ {
+		select {
+		case <-stop:
+			return
+		default:
+		}
+		d.Scene(&flipScene{on: i%2 == 0})
+		time.Sleep(50 * time.Microsecond)
+	}
+}
+
+// checkFrame fails the test if the rows of the frame aren't all full or all empty.
+func checkFrame(t *testing.T, c cube.Cube) {
+	t.Helper()
+	first := c.Row(0, 0)
+	for y := 0; y < c.YLen; y++ {
+		for z := 0; z < c.ZLen; z++ {
+			if c.Row(y, z) != first {
+				t.Fatalf("torn frame: row %d %d is %#x, row 0 0 is %#x", y, z, c.Row(y, z), first)
+			}
+		}
+	}
+}
+
+// TestDriverSceneSwitch draws from one goroutine while others switch and step the scenes.
+// Run with -race.
+func TestDriverSceneSwitch(t *testing.T) {
+	d := newTestDriver()
+	stop := make(chan struct{})
+	var wg sync.WaitGroup
+
+	wg.Add(2)
+	go switchScenes(d, stop, &wg)
+	go func() {
+		defer wg.Done()
+		for {
+			select {
+			case <-stop:
+				return
+			default:
+			}
+			d.Step()
+		}
+	}()
+
+	for deadline := time.Now().Add(time.Second); time.Now().Before(deadline); {
+		if err := d.Draw(); err != nil {
+			t.Fatal(err)
+		}
+		checkFrame(t, d.latest())
+	}
+	close(stop)
+	wg.Wait()
+}
+
+// TestRefreshSceneSwitch switches the scenes while the refresh goroutines run.
+// Run with -race.
+func TestRefreshSceneSwitch(t *testing.T) {
+	d := newTestDriver()
+	stop := make(chan struct{})
+	var wg sync.WaitGroup
+
+	if err := d.StartRefresh(2000); err != nil {
+		t.Fatal(err)
+	}
+	wg.Add(1)
+	go switchScenes(d, stop, &wg)
+	time.Sleep(time.Second)
+	close(stop)
+	wg.Wait()
+	if err := d.StopRefresh(); err != nil {
+		t.Fatal(err)
+	}
+	if s := d.RefreshStats(); s.Frames == 0 {
+		t.Fatalf("no frame refreshed: %s", s)
+	}
+}
+
+// countScene counts its steps.
+type countScene struct {
+	steps int64
+}
+
+func (s *countScene) Step(c cube.Cube) time.Duration {
+	atomic.AddInt64(&s.steps, 1)
+	return time.Millisecond
+}
+
+// TestRefreshRenderError checks a SPI error stops both refresh goroutines and is returned.
+func TestRefreshRenderError(t *testing.T) {
+	conn := &testConn{}
+	scene := &countScene{}
+	d := NewDriver(newTestAdaptor(conn), cube.New(8), scene)
+	fail := errors.New("tx")
+
+	if err := d.StartRefresh(1000); err != nil {
+		t.Fatal(err)
+	}
+	time.Sleep(20 * time.Millisecond)
+	select {
+	case <-d.RefreshDone():
+		t.Fatal("refresh stopped without error")
+	default:
+	}
+	conn.Lock()
+	conn.err = fail
+	conn.Unlock()
+
+	select {
+	case <-d.RefreshDone():
+	case <-time.After(time.Second):
+		t.Fatal("refresh still running after a render error")
+	}
+
+	// The scene goroutine doesn't step anymore.
+	time.Sleep(5 * time.Millisecond)
+	steps := atomic.LoadInt64(&scene.steps)
+	time.Sleep(20 * time.Millisecond)
+	if n := atomic.LoadInt64(&scene.steps); n != steps {
+		t.Fatalf("scene stepped %d times after the render error", n-steps)
+	}
+
+	if err := d.StopRefresh(); !errors.Is(err, fail) {
+		t.Fatalf("StopRefresh returned %v, expected %v", err, fail)
+	}
+}
+
+func BenchmarkDrawSceneSwitch(b *testing.B) {
+	d := newTestDriver()
+	stop := make(chan struct{})
+	var wg sync.WaitGroup
+
+	wg.Add(1)
+	go switchScenes(d, stop, &wg)
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if err := d.Draw(); err != nil {
+			b.Fatal(err)
+		}
+	}
+	b.StopTimer()
+	close(stop)
+	wg.Wait()
+}
@@ -0,0 +1,47 @@
+package spi595
+
+import (
+	"sync/atomic"
+
+	"github.com/geplo/cube"
+)
+
+// fresh is set on the middle slot index when it holds a frame the reader didn't take yet.
+const fresh = 0x04
+
+// frames is a lock-free triple buffer of cubes, for a single writer and a single reader.
+//
+// The writer copies its frame in the back slot and publishes it, the reader swaps in the
+// latest published slot as front. Neither side ever waits on the other, and the reader
+// always sees a complete frame.
+type frames struct {
+	slots  [3]cube.Cube
+	back   uint32 // Writer owned.
+	middle uint32 // Shared, slot index | fresh.
+	front  uint32 // Reader owned.
+}
+
+// newFrames allocates the slots for cubes of the size of c, all cleared.
+func newFrames(c cube.Cube) *frames {
+	f := &frames{back: 0, middle: 1, front: 2}
+	for i := range f.slots {
+		f.slots[i] = cube.NewCustom(c.XLen, c.YLen, c.ZLen)
+	}
+	return f
+}
+
+// publish copies c in the back slot and hands it over to the reader.
+func (f *frames) publish(c cube.Cube) {
+	f.slots[f.back].Copy(c)
+	f.back = atomic.SwapUint32(&f.middle, f.back|fresh) &^ fresh
+}
+
+// latest takes the latest published slot as front, if any, and returns the front,
+// telling if it changed.
+func (f *frames) latest() (cube.Cube, bool) {
+	changed := atomic.LoadUint32(&f.middle)&fresh != 0
+	if changed {
+		f.front = atomic.SwapUint32(&f.middle, f.front) &^ fresh
+	}
+	return f.slots[f.front], changed
+}
@@ -0,0 +1,218 @@
+package spi595
+
+import (
+	"fmt"
+	"math"
+	"runtime"
+	"sync"
+	"time"
+)
+
+// RefreshStats are the counters of the refresh loop.
+type RefreshStats struct {
+	Rate   int           // Target refresh rate, in Hz.
+	Frames uint64        // Number of refreshes.
+	Late   uint64        // Number of missed layer deadlines.
+	FPS    float64       // Achieved refresh rate, in Hz.
+	Min    time.Duration // Minimum layer wake up latency.
+	Max    time.Duration // Maximum layer wake up latency.
+	Mean   time.Duration // Mean layer wake up latency.
+	Stddev time.Duration // Standard deviation of the layer wake up latency.
+}
+
+func (s RefreshStats) String() string {
+	return fmt.Sprintf("%d frames at %.1f Hz (target %d Hz), %d late, wake up latency min %v, mean %v, max %v, stddev %v",
+		s.Frames, s.FPS, s.Rate, s.Late, s.Min, s.Mean, s.Max, s.Stddev)
+}
+
+// refresh is the state of a running refresh loop.
+type refresh struct {
+	rate int
+	stop chan struct{} // Closed by StopRefresh, or by the render goroutine on error.
+	once sync.Once
+	err  error // Render error, read once both goroutines exited.
+	wg   sync.WaitGroup
+
+	// Counters, written by the render goroutine.
+	sync.Mutex
+	start  time.Time
+	end    time.Time // Set once stopped.
+	frames uint64
+	layers uint64
+	late   uint64
+	min    time.Duration
+	max    time.Duration
+	sum    time.Duration
+	sum2   float64
+}
+
+// halt closes stop, once.
+func (r *refresh) halt() {
+	r.once.Do(func() { close(r.stop) })
+}
+
+// account records the wake up latency of a layer.
+func (r *refresh) account(latency time.Duration, late bool) {
+	r.Lock()
+	if r.layers == 0 || latency < r.min {
+		r.min = latency
+	}
+	if latency > r.max {
+		r.max = latency
+	}
+	r.sum += latency
+	r.sum2 += float64(latency) * float64(latency)
+	r.layers++
+	if late {
+		r.late++
+	}
+	r.Unlock()
+}
+
+// StartRefresh renders the cube at rate Hz from a dedicated goroutine locked to its OS thread,
+// and steps the scene from another one, until StopRefresh.
+// The layers share the refresh period evenly, each sent on its own absolute deadline.
+// A render error stops both goroutines, RefreshDone tells when.
+// Draw must not be called while refreshing, and StartRefresh, StopRefresh, RefreshDone and
+// RefreshStats not concurrently with each other.
+func (d *Driver) StartRefresh(rate int) error {
+	if rate <= 0 {
+		return fmt.Errorf("invalid refresh rate %d", rate)
+	}
+	if d.refresh != nil && d.refresh.end.IsZero() {
+		return fmt.Errorf("already refreshing")
+	}
+	r := &refresh{
+		rate:  rate,
+		stop:  make(chan struct{}),
+		start: time.Now(),
+	}
+	d.refresh = r
+	r.wg.Add(2)
+	go d.render(r)
+	go d.animate(r)
+	return nil
+}
+
+// StopRefresh stops the refresh loop and returns its render error, if any.
+func (d *Driver) StopRefresh() error {
+	r := d.refresh
+	if r == nil || !r.end.IsZero() {
+		return nil
+	}
+	r.halt()
+	r.wg.Wait()
+	r.end = time.Now()
+	return r.err
+}
+
+// RefreshDone returns a channel closed once the refresh loop stops, on StopRefresh or on
+// a render error, nil if it never started. StopRefresh then returns the error.
+func (d *Driver) RefreshDone() <-chan struct{} {
+	if d.refresh == nil {
+		return nil
+	}
+	return d.refresh.stop
+}
+
+// RefreshStats returns the counters of the refresh loop, running or last stopped.
+func (d *Driver) RefreshStats() RefreshStats {
+	r := d.refresh
+	if r == nil {
+		return RefreshStats{}
+	}
+	r.Lock()
+	defer r.Unlock()
+	end := r.end
+	if end.IsZero() {
+		end = time.Now()
+	}
+	s := RefreshStats{
+		Rate:   r.rate,
+		Frames: r.frames,
+		Late:   r.late,
+		FPS:    float64(r.frames) / end.Sub(r.start).Seconds(),
+		Min:    r.min,
+		Max:    r.max,
+	}
+	if r.layers != 0 {
+		mean := float64(r.sum) / float64(r.layers)
+		s.Mean = time.Duration(mean)
+		s.Stddev = time.Duration(math.Sqrt(math.Max(r.sum2/float64(r.layers)-mean*mean, 0)))
+	}
+	return s
+}
+
+// render is the render goroutine, only doing the layer multiplexing.
+// Each period, it takes the latest frame published by the scene side, maps it if it
+// changed, then sends each layer and sleeps until its deadline.
+func (d *Driver) render(r *refresh) {
+	defer r.wg.Done()
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+
+	period := time.Second / time.Duration(r.rate*d.Cube.YLen)
+	deadline := time.Now()
+	first := true
+
+	for {
+		select {
+		case <-r.stop:
+			return
+		default:
+		}
+
+		// Display the latest frame.
+		if c, changed := d.frames.latest(); changed || first {
+			d.connection.mapCube(c)
+			first = false
+		}
+		for y := 0; y < d.Cube.YLen; y++ {
+			if err := d.connection.renderLayer(y); err != nil {
+				r.err = err
+				r.halt()
+				return
+			}
+
+			// Wait for the layer deadline.
+			deadline = deadline.Add(period)
+			sleepUntil(deadline)
+
+			// If we missed a whole period, don't try to catch up.
+			latency := time.Since(deadline)
+			if latency < 0 {
+				latency = 0
+			}
+			r.account(latency, latency > period)
+			if latency > period {
+				deadline = deadline.Add(latency)
+			}
+		}
+
+		r.Lock()
+		r.frames++
+		r.Unlock()
+	}
+}
+
+// animate is the scene goroutine, stepping the scene when due or switched.
+func (d *Driver) animate(r *refresh) {
+	defer r.wg.Done()
+	timer := time.NewTimer(0)
+	defer timer.Stop()
+
+	for {
+		select {
+		case <-r.stop:
+			return
+		case <-d.switched:
+			if !timer.Stop() {
+				<-timer.C
+			}
+		case <-timer.C:
+		}
+		now := time.Now()
+		d.Publish(d.Event(Step), now)
+		timer.Reset(d.Step())
+	}
+}
@@ -0,0 +1,15 @@
+package spi595
+
+import (
+	"syscall"
+	"time"
+)
+
+// sleepUntil blocks the OS thread until the deadline with nanosleep(2), as the runtime
+// timers round short sleeps up to around a millisecond.
+func sleepUntil(deadline time.Time) {
+	for d := time.Until(deadline); d > 0; d = time.Until(deadline) {
+		ts := syscall.NsecToTimespec(int64(d))
+		_ = syscall.Nanosleep(&ts, nil)
+	}
+}
@@ -0,0 +1,11 @@
+//go:build !linux
+// +build !linux
+
+package spi595
+
+import "time"
+
+// sleepUntil sleeps until the deadline.
+func sleepUntil(deadline time.Time) {
+	time.Sleep(time.Until(deadline))
+}